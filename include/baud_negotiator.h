@@ -0,0 +1,49 @@
+#ifndef BAUD_NEGOTIATOR_H
+#define BAUD_NEGOTIATOR_H
+
+#include "config.h"
+#include "serial_channel.h"
+
+// Negotiates the baud rate of one device link
+//
+// Protocol (one line each, the daemon answers every command):
+//   BAUD:<rate>   -> BAUD:OK:<rate> at the current rate, then both ends switch
+//                 -> BAUD:NO:<max> if the daemon does not support the rate
+//   ECHO:<text>   -> ECHO:<text>, repeated BAUD_ECHO_COUNT times at the new rate
+//   BAUD:COMMIT   -> BAUD:OK, the daemon keeps the new rate
+// Without BAUD:COMMIT the daemon returns to the previous rate after 2 seconds.
+class BaudNegotiator {
+private:
+    SerialChannel* channel;
+    int deviceId;
+    int rateIndex;                  // Current rate in BAUD_RATES
+    int ceilingIndex;               // Highest rate the daemon accepts
+    int missedPolls;                // Consecutive missed polls at the current rate
+    unsigned long waitStart;
+    unsigned long waitDuration;     // No negotiation before waitStart + waitDuration
+    
+    bool echoTest();
+    void setRate(int index);
+    void postpone(unsigned long duration);
+
+public:
+    BaudNegotiator();
+    
+    // Attach the device link, which must already run at BAUD_RATE
+    void begin(SerialChannel* serialChannel, int device);
+    
+    // Check if a step to a higher rate is due
+    bool shouldNegotiate() const;
+    
+    // Try the next higher rate; blocks for at most (BAUD_ECHO_COUNT + 2) response timeouts
+    // Returns true if the link now runs at the higher rate
+    bool negotiate();
+    
+    // Record the outcome of a poll, returning to BAUD_RATE after repeated misses
+    void recordPoll(bool answered);
+    
+    // Get the current baud rate
+    long getBaudRate() const;
+};
+
+#endif // BAUD_NEGOTIATOR_H
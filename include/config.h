@@ -2,7 +2,37 @@
 #define CONFIG_H
 
 // --- Serial Communication Speed ---
+// Every device starts at BAUD_RATE. The controller then steps each device up through
+// BAUD_RATES as long as the new rate passes an echo test, and returns to BAUD_RATE when
+// a device stops answering at a negotiated rate
 const long BAUD_RATE = 38400;
+const long BAUD_RATES[] = {38400, 57600, 115200};    // Negotiation ladder, starting with BAUD_RATE
+const int NUM_BAUD_RATES = sizeof(BAUD_RATES) / sizeof(BAUD_RATES[0]);
+const bool BAUD_NEGOTIATION = true;                  // false keeps every device at BAUD_RATE
+const int BAUD_ECHO_COUNT = 4;                       // Echo lines that must come back intact at a new rate
+const int BAUD_FALLBACK_MISSES = 3;                  // Missed polls at a negotiated rate before returning to BAUD_RATE
+const unsigned long BAUD_RETRY_INTERVAL = 300000;    // Wait after a failed step before trying it again
+const unsigned long BAUD_RENEGOTIATE_DELAY = 10000;  // Wait after a fallback (the daemon falls back after 5s of silence)
+const int BAUD_SWITCH_DELAY = 20;                    // Let both ends settle after a rate change (ms)
+
+// --- Wire Format ---
+// Devices that confirm PROTO:BIN are polled with POLL:BIN and answer with a 16-byte
+// COBS-framed binary packet with a CRC-8 (lib/wire_protocol) instead of ~60 bytes of text
+const bool BINARY_PROTOCOL = true;                   // false keeps every device on text responses
+const int BINARY_FALLBACK_MISSES = 3;                // Missed polls in a negotiated format before returning to plain text
+const unsigned long BINARY_RETRY_INTERVAL = 300000;  // Wait after a refused request before asking again
+const unsigned long BINARY_RENEGOTIATE_DELAY = 10000;  // Wait after a fallback before asking again
+
+// --- Push Mode ---
+// Devices that confirm PUSH:ON (or PUSH:BIN) are no longer polled: the daemon sends an update
+// when a temperature changes by its push delta, and at least once per heartbeat. SoftwareSerial
+// hears only one port at a time, so the controller listens to pushing devices in turns of
+// LISTEN_SLOT and answers every update with ACK; the daemon repeats an update until then
+const bool PUSH_MODE = true;                         // false polls every device every POLL_INTERVAL
+const unsigned long LISTEN_SLOT = 50;                // Listening turn per pushing device (the daemon repeats every 50ms)
+const unsigned long PUSH_STALE_MARGIN = 1000;        // Poll again after two heartbeats plus this without an update
+const unsigned long PUSH_RETRY_INTERVAL = 300000;    // Wait after a refused request before asking again
+const unsigned long PUSH_RENEGOTIATE_DELAY = 10000;  // Wait after updates stopped before asking again
 
 // --- Pin Definitions for Arduino Pro Mini ---
 const int FAN_PWM_PIN = 9;    // PWM output for fan control
@@ -27,6 +57,8 @@ const int NUM_DEVICES = 4;
 const unsigned long POLL_INTERVAL = 1000;        // Poll devices every 1 second
 const unsigned long RESPONSE_TIMEOUT = 200;      // Wait 200ms for response
 const int MAX_MISSED_POLLS = 10;                 // Consider device disconnected after 10 missed polls
+const unsigned int MAX_RESPONSE_LENGTH = 80;     // Longest valid device response (CPU:xx.xx|NVME:xx.xx|AGE:ms|DCPU:x.xx|DNVME:x.xx|LOAD:pct)
+const unsigned int MAX_NEGOTIATION_LENGTH = 24;  // Longest negotiation line (ECHO:<i>:<pattern>), longer lines are cut
 
 // --- Temperature Thresholds for Fan Control ---
 // CPU temperature thresholds (in °C)
@@ -37,6 +69,25 @@ const float CPU_TEMP_MAX = 60.0;   // Above this, fan at maximum speed
 const float NVME_TEMP_MIN = 40.0;  // Below this, fan at minimum speed
 const float NVME_TEMP_MAX = 65.0;  // Above this, fan at maximum speed
 
+// --- Temperature Trend Feed-Forward ---
+// A rising temperature (DCPU/DNVME slope in °C/s) is treated as the temperature it will reach
+// TREND_LOOKAHEAD_SEC later, so the fan ramps up before the peak instead of after it
+const float TREND_LOOKAHEAD_SEC = 10.0;          // How far ahead a positive slope is projected
+const float TREND_MAX_BOOST = 10.0;              // Upper limit of the projected increase (°C)
+
+// --- Fan Control Mode ---
+// CONTROL_TEMPERATURE: fan speed follows the temperature curves only
+// CONTROL_TEMPERATURE_AND_LOAD: CPU load reported by the devices also raises the fan speed,
+// so it starts ramping when a job starts instead of when the temperature catches up
+enum ControlMode {
+    CONTROL_TEMPERATURE,
+    CONTROL_TEMPERATURE_AND_LOAD
+};
+const ControlMode CONTROL_MODE = CONTROL_TEMPERATURE_AND_LOAD;
+const int LOAD_MIN = 50;                         // Below this CPU load (%), load does not raise the fan
+const int LOAD_MAX = 100;                        // At this CPU load (%), load alone drives LOAD_FAN_SPEED_MAX
+const int LOAD_FAN_SPEED_MAX = 180;              // Highest PWM value driven by load alone (temperature decides above)
+
 // --- Fan Speed Settings ---
 const int FAN_SPEED_MIN = 30;                    // Minimum PWM value (0-255)
 const int FAN_SPEED_MAX = 255;                   // Maximum PWM value (0-255)
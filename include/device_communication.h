@@ -5,6 +5,10 @@
 #include <SoftwareSerial.h>
 #include "config.h"
 #include "temperature_sensor.h"
+#include "serial_channel.h"
+#include "baud_negotiator.h"
+#include "protocol_negotiator.h"
+#include <wire_protocol.h>
 
 class DeviceCommunication {
 private:
@@ -13,15 +17,38 @@ private:
     SoftwareSerial device3;
     SoftwareSerial device4;
     SoftwareSerial* devices[NUM_DEVICES];
+    SoftwareSerialChannel channels[NUM_DEVICES];
+    BaudNegotiator negotiators[NUM_DEVICES];
+    ProtocolNegotiator protocols[NUM_DEVICES];
     
-    String incomingData[NUM_DEVICES];
+    // Response of the device being listened to; SoftwareSerial receives on one port at a time
+    union {
+        char line[MAX_RESPONSE_LENGTH + 1];
+        uint8_t frame[WIRE_MAX_FRAME];    // Binary response without its delimiter
+    };
+    size_t received;                      // Bytes in line or frame
     bool deviceResponded[NUM_DEVICES];
     
     unsigned long lastPollTime;
     unsigned long commandSentTime;
     int currentPollingDevice;
     
+    int listeningDevice;              // The one port SoftwareSerial receives on
+    unsigned long listenStart;
+    bool listenHeard;                 // Bytes of an update received in this listening turn
+    bool resyncing;                   // Listening started mid-update: drop bytes up to the next delimiter
+    
     TemperatureSensor* tempSensor;
+    
+    // Feed one received byte to the response of a device
+    // Returns 1 for a valid complete response, 0 for an invalid one, -1 while incomplete
+    int receiveByte(int deviceId, int c);
+    
+    // Finish with the device being polled and move on to the next
+    void advancePolling();
+    
+    // Give the next pushing device its listening turn once the current one is over
+    void rotateListening();
 
 public:
     DeviceCommunication();
@@ -29,13 +56,16 @@ public:
     // Initialize device communication
     void begin(TemperatureSensor* temperatureSensor);
     
-    // Poll all devices in sequence
+    // Poll all devices in sequence, skipping devices that push their updates
     void pollDevices();
     
-    // Process response from specific device
-    void processSerialResponse(int deviceId, const String& response);
+    // Process response from specific device, returns true for valid temperature data
+    bool processSerialResponse(int deviceId, const char* response);
+    
+    // Process a binary response frame (without its delimiter), returns true for valid temperature data
+    bool processBinaryResponse(int deviceId, const uint8_t* frameData, size_t length);
     
-    // Check for incoming data from all devices (outside of polling)
+    // Check for incoming data and push updates from all devices (outside of polling)
     void checkIncomingData();
     
     // Get device by ID
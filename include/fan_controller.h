@@ -13,6 +13,12 @@ private:
     
     // Calculate fan speed based on temperature with parabolic curve
     int calculateFanSpeed(float temp, float minTemp, float maxTemp) const;
+    
+    // Feed-forward temperature increase for a rising trend
+    float calculateTrendBoost(float slope) const;
+    
+    // Calculate fan speed driven by CPU load (CONTROL_TEMPERATURE_AND_LOAD mode)
+    int calculateLoadFanSpeed(int load) const;
 
 public:
     FanController();
@@ -0,0 +1,81 @@
+#ifndef PROTOCOL_NEGOTIATOR_H
+#define PROTOCOL_NEGOTIATOR_H
+
+#include "config.h"
+#include "serial_channel.h"
+
+// Negotiates the wire format of one device link
+//
+// Protocol (one line each):
+//   PROTO:BIN  -> PROTO:OK:BIN if the daemon can answer POLL:BIN with a binary frame
+//              -> PROTO:NO, or no answer from older daemons: keep polling with POLL
+//   PROTO:EXT  -> PROTO:OK:EXT if the daemon adds the trend and load fields to POLL:EXT
+//                 responses (asked when the binary format is disabled or refused)
+//              -> PROTO:NO, or no answer: keep polling with POLL, which carries neither
+// The daemon keeps no per-link state, so the negotiated format survives daemon restarts.
+//
+//   PUSH:BIN or PUSH:ON -> PUSH:OK:<heartbeat ms> once the daemon streams updates itself
+//                       -> PUSH:NO, or no answer: keep polling
+// Push mode is daemon state; when updates stop for two heartbeats the device is polled again.
+class ProtocolNegotiator {
+private:
+    SerialChannel* channel;
+    int deviceId;
+    bool binary;                    // Poll with POLL:BIN and expect binary frames
+    bool extended;                  // Poll with POLL:EXT for the trend and load fields
+    int missedPolls;                // Consecutive missed polls in a negotiated format
+    unsigned long waitStart;
+    unsigned long waitDuration;     // No negotiation before waitStart + waitDuration
+    bool pushing;                   // The daemon sends updates without being polled
+    unsigned long heartbeat;        // Longest interval between push updates (ms)
+    unsigned long lastPush;         // Time of the last push update, or of the request
+    unsigned long pushWaitStart;
+    unsigned long pushWaitDuration; // No push request before pushWaitStart + pushWaitDuration
+    
+    void postpone(unsigned long duration);
+    void postponePush(unsigned long duration);
+
+public:
+    ProtocolNegotiator();
+    
+    // Attach the device link, which starts out in the text format
+    void begin(SerialChannel* serialChannel, int device);
+    
+    // Check if the wire format should be negotiated
+    bool shouldNegotiate() const;
+    
+    // Request the binary format, or extended text responses if it is disabled or refused;
+    // blocks for at most two response timeouts
+    // Returns true if the device is now polled in a negotiated format
+    bool negotiate();
+    
+    // Record the outcome of a poll, returning to plain text after repeated misses
+    void recordPoll(bool answered);
+    
+    // Check if the device is polled in the binary format
+    bool isBinary() const;
+    
+    // Check if the device is polled with POLL:EXT
+    bool isExtended() const;
+    
+    // Check if push mode should be requested
+    bool shouldRequestPush() const;
+    
+    // Request push mode in the current format; blocks for at most one response timeout
+    // Returns true if the daemon now sends updates on its own
+    bool requestPush();
+    
+    // Record a push update received from the device
+    void recordPush();
+    
+    // Check if the device is in push mode
+    bool isPushing() const;
+    
+    // Check if push updates stopped arriving, so the device must be polled again
+    bool isStale() const;
+    
+    // Leave push mode after updates stopped, to ask for it again later
+    void pushLost();
+};
+
+#endif // PROTOCOL_NEGOTIATOR_H
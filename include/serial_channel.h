@@ -0,0 +1,41 @@
+#ifndef SERIAL_CHANNEL_H
+#define SERIAL_CHANNEL_H
+
+#include <stddef.h>
+
+class SoftwareSerial;
+
+// Serial link to one device as used by the protocol code, so that the code
+// can run against SoftwareSerial on the board or a simulated channel on a host.
+// Hardware headers stay in serial_channel.cpp, out of every host build.
+class SerialChannel {
+public:
+    virtual ~SerialChannel() {}
+    
+    // Change the baud rate of the link
+    virtual void begin(long baudRate) = 0;
+    
+    // Send one line, terminated with "\r\n", and wait until it has been transmitted
+    virtual void writeLine(const char* line) = 0;
+    
+    // Read one received byte, -1 if none is available
+    virtual int read() = 0;
+    
+    // Wait up to timeout ms for a line starting with prefix, skipping any other lines
+    virtual bool awaitLine(const char* prefix, char* line, size_t size, unsigned long timeout) = 0;
+};
+
+class SoftwareSerialChannel : public SerialChannel {
+private:
+    SoftwareSerial* port;
+
+public:
+    SoftwareSerialChannel(SoftwareSerial* serialPort = nullptr);
+    
+    void begin(long baudRate) override;
+    void writeLine(const char* line) override;
+    int read() override;
+    bool awaitLine(const char* prefix, char* line, size_t size, unsigned long timeout) override;
+};
+
+#endif // SERIAL_CHANNEL_H
@@ -9,6 +9,10 @@ struct TemperatureData {
     float nvmeTemp;
     bool isValid;
     unsigned long lastUpdateTime;
+    unsigned long sampleAgeMs;    // Age of the readings on the device when it answered
+    float cpuSlope;               // Temperature trend reported by the device (°C/s)
+    float nvmeSlope;
+    int cpuLoad;                  // CPU utilization reported by the device (%), -1 if not reported
 };
 
 // Forward declaration to avoid circular dependency
@@ -33,12 +37,22 @@ public:
     // Parse temperature data from device response
     bool parseTemperatureData(int deviceId, const String& data);
     
+    // Store readings received from a device and update the fan speed
+    void updateTemperatureData(int deviceId, float cpuTemp, float nvmeTemp, unsigned long sampleAge,
+                               float cpuSlope, float nvmeSlope, int cpuLoad);
+    
     // Get temperature data for specific device
     TemperatureData getDeviceTemperature(int deviceId) const;
     
     // Get highest temperatures across all devices
     void getHighestTemperatures(float& highestCpu, float& highestNvme) const;
     
+    // Get steepest rising temperature trends across all devices (°C/s, 0 if none is rising)
+    void getHighestSlopes(float& highestCpuSlope, float& highestNvmeSlope) const;
+    
+    // Get highest CPU load across all connected devices (%, -1 if no device reports it)
+    int getHighestLoad() const;
+    
     // Check if any temperature data is available
     bool hasTemperatureData() const;
     
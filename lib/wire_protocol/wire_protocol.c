@@ -0,0 +1,136 @@
+/**
+ * Binary wire protocol shared by the fan controller and the daemon
+ * COBS framing and CRC-8 over small fixed-layout packets. Plain C without
+ * allocation or floating point, so the same file builds for AVR and Linux
+ */
+
+#include "wire_protocol.h"
+
+/**
+ * CRC-8 with polynomial 0x07, initial value 0 and no final XOR
+ * A packet followed by its CRC has a CRC of 0
+ */
+uint8_t wire_crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+    
+    while (len-- > 0) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * COBS-encode a packet so that it contains no 0x00 byte
+ * The output needs len + len / 254 + 1 bytes; returns its length
+ */
+size_t wire_cobs_encode(const uint8_t *data, size_t len, uint8_t *out) {
+    size_t code_pos = 0;
+    size_t out_len = 1;
+    uint8_t code = 1;
+    
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != 0) {
+            out[out_len++] = data[i];
+            code++;
+        }
+        // A zero, or a full block of 254 data bytes, ends the current block
+        if (data[i] == 0 || code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = out_len++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    return out_len;
+}
+
+/**
+ * Decode a COBS frame, given without its 0x00 delimiter
+ * The output needs len bytes; returns the packet length, 0 if the frame is malformed
+ */
+size_t wire_cobs_decode(const uint8_t *data, size_t len, uint8_t *out) {
+    size_t out_len = 0;
+    size_t i = 0;
+    
+    while (i < len) {
+        uint8_t code = data[i++];
+        if (code == 0 || i + code - 1 > len) {
+            return 0;
+        }
+        for (uint8_t j = 1; j < code; j++) {
+            if (data[i] == 0) {
+                return 0;
+            }
+            out[out_len++] = data[i++];
+        }
+        // Every block but a full one or the last stands for a zero
+        if (code != 0xFF && i < len) {
+            out[out_len++] = 0;
+        }
+    }
+    return out_len;
+}
+
+/**
+ * Store a 16-bit value little-endian
+ */
+static void put_u16(uint8_t *out, uint16_t value) {
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * Load a little-endian 16-bit value
+ */
+static uint16_t get_u16(const uint8_t *in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+/**
+ * Encode a temperatures packet as a delimited frame of at most WIRE_MAX_FRAME bytes
+ * Returns the frame length including the 0x00 delimiter
+ */
+size_t wire_encode_temperatures(const wire_temperatures_t *values, uint8_t *frame) {
+    uint8_t packet[WIRE_TEMPERATURES_LENGTH];
+    
+    packet[0] = WIRE_TYPE_TEMPERATURES;
+    packet[1] = values->flags;
+    put_u16(packet + 2, (uint16_t)values->cpu_centi);
+    put_u16(packet + 4, (uint16_t)values->nvme_centi);
+    put_u16(packet + 6, values->age_ms);
+    put_u16(packet + 8, (uint16_t)values->cpu_slope_centi);
+    put_u16(packet + 10, (uint16_t)values->nvme_slope_centi);
+    packet[12] = values->load_pct;
+    packet[13] = wire_crc8(packet, WIRE_TEMPERATURES_LENGTH - 1);
+    
+    size_t len = wire_cobs_encode(packet, sizeof(packet), frame);
+    frame[len++] = 0;
+    return len;
+}
+
+/**
+ * Decode a temperatures frame, given without its 0x00 delimiter
+ * Returns 0 on success, -1 if the frame is malformed, corrupted or of another type
+ */
+int wire_decode_temperatures(const uint8_t *frame, size_t len, wire_temperatures_t *values) {
+    uint8_t packet[WIRE_MAX_FRAME];
+    
+    if (len > sizeof(packet) ||
+        wire_cobs_decode(frame, len, packet) != WIRE_TEMPERATURES_LENGTH ||
+        wire_crc8(packet, WIRE_TEMPERATURES_LENGTH) != 0 ||
+        packet[0] != WIRE_TYPE_TEMPERATURES) {
+        return -1;
+    }
+    
+    values->flags = packet[1];
+    values->cpu_centi = (int16_t)get_u16(packet + 2);
+    values->nvme_centi = (int16_t)get_u16(packet + 4);
+    values->age_ms = get_u16(packet + 6);
+    values->cpu_slope_centi = (int16_t)get_u16(packet + 8);
+    values->nvme_slope_centi = (int16_t)get_u16(packet + 10);
+    values->load_pct = packet[12];
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef WIRE_PROTOCOL_H
+#define WIRE_PROTOCOL_H
+
+// Binary wire format shared by the fan controller firmware and the Raspberry Pi daemon
+//
+// A packet is a type byte, a fixed payload and a CRC-8 (polynomial 0x07) over both,
+// sent COBS-encoded and terminated with a 0x00 byte. Multi-byte fields are little-endian.
+//
+// Temperatures packet (WIRE_TYPE_TEMPERATURES), 14 bytes, 16 on the wire:
+//   type, flags, cpu, nvme (int16, 0.01 degC), age (uint16, ms),
+//   cpu slope, nvme slope (int16, 0.01 degC/s), load (uint8, %), crc
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WIRE_TYPE_TEMPERATURES   0x81
+#define WIRE_FLAG_TREND          0x01   // Slope fields are valid
+#define WIRE_FLAG_LOAD           0x02   // Load field is valid
+#define WIRE_TEMPERATURES_LENGTH 14     // Packet length including type and CRC
+#define WIRE_MAX_PACKET          32
+#define WIRE_MAX_FRAME           (WIRE_MAX_PACKET + 2)   // COBS overhead byte and delimiter
+#define WIRE_CENTI_MAX           32767
+
+// Readings carried by a temperatures packet
+typedef struct {
+    uint8_t flags;
+    int16_t cpu_centi;
+    int16_t nvme_centi;
+    uint16_t age_ms;
+    int16_t cpu_slope_centi;
+    int16_t nvme_slope_centi;
+    uint8_t load_pct;
+} wire_temperatures_t;
+
+// Function prototypes
+uint8_t wire_crc8(const uint8_t *data, size_t len);
+size_t wire_cobs_encode(const uint8_t *data, size_t len, uint8_t *out);
+size_t wire_cobs_decode(const uint8_t *data, size_t len, uint8_t *out);
+size_t wire_encode_temperatures(const wire_temperatures_t *values, uint8_t *frame);
+int wire_decode_temperatures(const uint8_t *frame, size_t len, wire_temperatures_t *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WIRE_PROTOCOL_H
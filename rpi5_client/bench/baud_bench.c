@@ -0,0 +1,161 @@
+/**
+ * Baud rate round-trip benchmark for Fan Temperature Daemon
+ * Applies each rate through termios2, verifies it by reading it back and
+ * times POLL/response round trips. Without arguments a pty pair stands in
+ * for the controller; with a device argument, bytes are sent through that
+ * port and must come back on a TX-RX loopback wire
+ */
+
+#define _GNU_SOURCE
+#include "baud.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <time.h>
+
+#define ROUND_TRIPS  200
+#define TIMEOUT_MS   1000
+
+static const char POLL_LINE[] = "POLL\r\n";
+static const char RESPONSE_LINE[] = "CPU:55.50|NVME:47.00|AGE:123|DCPU:0.00|DNVME:0.00|LOAD:12\n";
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int make_raw(int fd) {
+    struct termios tty;
+    
+    if (tcgetattr(fd, &tty) != 0) {
+        return -1;
+    }
+    cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    return tcsetattr(fd, TCSANOW, &tty);
+}
+
+/**
+ * Read exactly len bytes, waiting at most TIMEOUT_MS for each chunk
+ */
+static int read_exact(int fd, char *buffer, size_t len) {
+    size_t got = 0;
+    
+    while (got < len) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, TIMEOUT_MS) <= 0) {
+            return -1;
+        }
+        ssize_t n = read(fd, buffer + got, len - got);
+        if (n <= 0) {
+            return -1;
+        }
+        got += (size_t)n;
+    }
+    return 0;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * One POLL and its response between the controller and daemon ends
+ * For a loopback device both ends are the same fd and each line comes straight back
+ */
+static int round_trip(int controller_fd, int daemon_fd, double *elapsed_us) {
+    char buffer[sizeof(RESPONSE_LINE)];
+    double start = now_us();
+    
+    if (write(controller_fd, POLL_LINE, sizeof(POLL_LINE) - 1) < 0 ||
+        read_exact(daemon_fd, buffer, sizeof(POLL_LINE) - 1) != 0 ||
+        memcmp(buffer, POLL_LINE, sizeof(POLL_LINE) - 1) != 0) {
+        return -1;
+    }
+    
+    if (write(daemon_fd, RESPONSE_LINE, sizeof(RESPONSE_LINE) - 1) < 0 ||
+        read_exact(controller_fd, buffer, sizeof(RESPONSE_LINE) - 1) != 0 ||
+        memcmp(buffer, RESPONSE_LINE, sizeof(RESPONSE_LINE) - 1) != 0) {
+        return -1;
+    }
+    
+    *elapsed_us = now_us() - start;
+    return 0;
+}
+
+static int open_pty(int *controller_fd, int *daemon_fd) {
+    *controller_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (*controller_fd < 0 || grantpt(*controller_fd) != 0 || unlockpt(*controller_fd) != 0) {
+        return -1;
+    }
+    
+    *daemon_fd = open(ptsname(*controller_fd), O_RDWR | O_NOCTTY);
+    if (*daemon_fd < 0) {
+        return -1;
+    }
+    return make_raw(*controller_fd) == 0 && make_raw(*daemon_fd) == 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    static const int rates[] = {9600, 38400, 115200, 230400, 460800, 500000, 1000000};
+    int controller_fd;
+    int daemon_fd;
+    int failures = 0;
+    
+    if (argc > 1) {
+        controller_fd = open(argv[1], O_RDWR | O_NOCTTY);
+        daemon_fd = controller_fd;
+        if (controller_fd < 0 || make_raw(controller_fd) != 0) {
+            perror(argv[1]);
+            return EXIT_FAILURE;
+        }
+    } else if (open_pty(&controller_fd, &daemon_fd) != 0) {
+        perror("pty");
+        return EXIT_FAILURE;
+    }
+    
+    printf("%-10s %10s %12s %12s %12s\n", "rate", "readback", "wire us", "median us", "p99 us");
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        double samples[ROUND_TRIPS];
+        int actual = 0;
+        
+        if (baud_set(daemon_fd, rates[i]) != 0 || baud_get(daemon_fd, &actual) != 0) {
+            printf("%-10d %10s\n", rates[i], "failed");
+            failures++;
+            continue;
+        }
+        
+        tcflush(daemon_fd, TCIOFLUSH);
+        
+        int completed = 0;
+        while (completed < ROUND_TRIPS && round_trip(controller_fd, daemon_fd, &samples[completed]) == 0) {
+            completed++;
+        }
+        
+        // Ten bits per byte (8N1) for the POLL and the response
+        double wire_us = (sizeof(POLL_LINE) - 1 + sizeof(RESPONSE_LINE) - 1) * 10 * 1e6 / rates[i];
+        
+        if (completed < ROUND_TRIPS || actual != rates[i]) {
+            printf("%-10d %10d %12.0f %12s\n", rates[i], actual, wire_us, "failed");
+            failures++;
+            continue;
+        }
+        
+        qsort(samples, ROUND_TRIPS, sizeof(samples[0]), compare_doubles);
+        printf("%-10d %10d %12.0f %12.1f %12.1f\n", rates[i], actual, wire_us,
+               samples[ROUND_TRIPS / 2], samples[ROUND_TRIPS * 99 / 100]);
+    }
+    
+    close(controller_fd);
+    if (daemon_fd != controller_fd) {
+        close(daemon_fd);
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,442 @@
+/**
+ * Fake fan controller for Fan Temperature Daemon
+ * Starts the daemon on a pty and polls it the way DeviceCommunication::pollDevices does:
+ * one POLL at a time, then up to the response timeout for the answer. Garbage lines and
+ * POLLs split across writes can be mixed in. Reports the response latency distribution
+ * and timeouts, and with -s the highest POLL rate answered without a timeout
+ */
+
+#include <wire_protocol.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define RESPONSE_TIMEOUT_MS 200     // RESPONSE_TIMEOUT of the controller firmware
+#define STARTUP_TIMEOUT_MS  5000    // Wait for the first answered POLL
+#define MAX_RESPONSE        128
+#define MAX_GARBAGE         24      // Longest garbage line, without its line ending
+
+static const int g_sweep_rates[] = {10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000};
+
+typedef struct {
+    const char *daemon_path;
+    int rate;               // POLLs per second, 0 sends the next POLL as soon as one is answered
+    double duration_sec;
+    int binary;             // POLL:BIN, answers checked with the wire protocol decoder
+    int garbage_pct;        // POLLs preceded by a line of random bytes
+    int partial_pct;        // POLLs written in two parts with a pause between them
+    int timeout_ms;
+    int sweep;
+    int low_latency;        // Start the daemon with FAN_TEMP_LOW_LATENCY=1
+    int verbose;            // Show the daemon's log
+} options_t;
+
+typedef struct {
+    double *latencies_ms;
+    size_t capacity;
+    unsigned long polls;
+    unsigned long answered;
+    unsigned long timeouts;
+    unsigned long invalid;  // Answers that are not a temperatures response
+    unsigned long garbage_lines;
+    unsigned long partial_polls;
+    double elapsed_sec;
+} run_stats_t;
+
+static char g_sysfs_root[] = "/tmp/fake_controller.XXXXXX";
+static const char *const g_sysfs_dirs[] = {
+    "class", "class/thermal", "class/thermal/thermal_zone0", "class/hwmon", "class/hwmon/hwmon0"
+};
+static const char *const g_sysfs_files[][2] = {
+    {"class/thermal/thermal_zone0/type", "cpu-thermal\n"},
+    {"class/thermal/thermal_zone0/temp", "52375\n"},
+    {"class/hwmon/hwmon0/name", "nvme\n"},
+    {"class/hwmon/hwmon0/temp1_input", "41850\n"},
+};
+#define SYSFS_DIRS  (sizeof(g_sysfs_dirs) / sizeof(g_sysfs_dirs[0]))
+#define SYSFS_FILES (sizeof(g_sysfs_files) / sizeof(g_sysfs_files[0]))
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void sleep_until(int64_t deadline_ns) {
+    struct timespec ts = {deadline_ns / 1000000000LL, deadline_ns % 1000000000LL};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+/**
+ * Sensor tree with one CPU thermal zone and one NVME hwmon chip, so the daemon
+ * reads the same values on any machine
+ */
+static int create_sysfs(void) {
+    char path[256];
+    
+    if (mkdtemp(g_sysfs_root) == NULL) {
+        perror("mkdtemp");
+        return -1;
+    }
+    
+    for (size_t i = 0; i < SYSFS_DIRS; i++) {
+        snprintf(path, sizeof(path), "%s/%s", g_sysfs_root, g_sysfs_dirs[i]);
+        mkdir(path, 0755);
+    }
+    for (size_t i = 0; i < SYSFS_FILES; i++) {
+        snprintf(path, sizeof(path), "%s/%s", g_sysfs_root, g_sysfs_files[i][0]);
+        FILE *file = fopen(path, "w");
+        if (file == NULL) {
+            perror(path);
+            return -1;
+        }
+        fputs(g_sysfs_files[i][1], file);
+        fclose(file);
+    }
+    return 0;
+}
+
+static void remove_sysfs(void) {
+    char path[256];
+    
+    for (size_t i = 0; i < SYSFS_FILES; i++) {
+        snprintf(path, sizeof(path), "%s/%s", g_sysfs_root, g_sysfs_files[i][0]);
+        unlink(path);
+    }
+    for (size_t i = SYSFS_DIRS; i > 0; i--) {
+        snprintf(path, sizeof(path), "%s/%s", g_sysfs_root, g_sysfs_dirs[i - 1]);
+        rmdir(path);
+    }
+    rmdir(g_sysfs_root);
+}
+
+/**
+ * Run the daemon in the foreground on the pty slave
+ */
+static pid_t start_daemon(const options_t *options, const char *port) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+    
+    if (!options->verbose) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+    }
+    setenv("FAN_TEMP_SERIAL_PORT", port, 1);
+    setenv("FAN_TEMP_BAUD_RATE", "38400", 1);
+    setenv("FAN_TEMP_READ_TIMEOUT", "1", 1);
+    setenv("FAN_TEMP_FOREGROUND", "1", 1);
+    setenv("FAN_TEMP_LOG_TO_SYSLOG", "0", 1);
+    setenv("FAN_TEMP_VERBOSE", options->verbose ? "1" : "0", 1);
+    setenv("FAN_TEMP_SYSFS_ROOT", g_sysfs_root, 1);
+    setenv("FAN_TEMP_CPU_SOURCE", "native", 1);
+    setenv("FAN_TEMP_NVME_SOURCE", "native", 1);
+    setenv("FAN_TEMP_LOW_LATENCY", options->low_latency ? "1" : "0", 1);
+    execl(options->daemon_path, options->daemon_path, (char *)NULL);
+    perror(options->daemon_path);
+    _exit(127);
+}
+
+/**
+ * Drop anything still arriving from an earlier POLL, as the firmware does before polling
+ */
+static void drain(int fd) {
+    char buffer[256];
+    while (read(fd, buffer, sizeof(buffer)) > 0) {
+    }
+}
+
+/**
+ * Wait for one response: a line, or a 0x00-terminated frame in binary mode
+ * Returns 1 for a temperatures response, 0 for anything else, -1 on timeout
+ */
+static int read_response(int fd, int binary, int timeout_ms) {
+    unsigned char response[MAX_RESPONSE];
+    size_t len = 0;
+    int64_t deadline_ns = now_ns() + (int64_t)timeout_ms * 1000000LL;
+    
+    for (;;) {
+        int64_t left_ms = (deadline_ns - now_ns()) / 1000000LL;
+        struct pollfd pfd = {fd, POLLIN, 0};
+        
+        if (left_ms < 0 || poll(&pfd, 1, (int)left_ms + 1) <= 0) {
+            return -1;
+        }
+        
+        unsigned char c;
+        while (read(fd, &c, 1) == 1) {
+            if (c == (binary ? 0 : '\n')) {
+                if (binary) {
+                    wire_temperatures_t values;
+                    return wire_decode_temperatures(response, len, &values) == 0;
+                }
+                return len >= 4 && memcmp(response, "CPU:", 4) == 0;
+            }
+            if (len < sizeof(response)) {
+                response[len++] = c;
+            }
+        }
+    }
+}
+
+static void send_garbage(int fd) {
+    char line[MAX_GARBAGE + 2];
+    int len = 1 + rand() % MAX_GARBAGE;
+    
+    for (int i = 0; i < len; i++) {
+        do {
+            line[i] = (char)(rand() % 256);
+        } while (line[i] == '\n' || line[i] == '\r');
+    }
+    line[len++] = '\r';
+    line[len++] = '\n';
+    if (write(fd, line, len) < 0) {
+        perror("write");
+    }
+}
+
+/**
+ * Send a POLL, println-style; a partial POLL is split at a random point
+ */
+static void send_poll(int fd, int binary, int partial) {
+    const char *command = binary ? "POLL:BIN\r\n" : "POLL\r\n";
+    size_t len = strlen(command);
+    size_t split = partial ? 1 + rand() % (len - 1) : len;
+    
+    if (write(fd, command, split) < 0) {
+        perror("write");
+    }
+    if (split < len) {
+        usleep(500 + rand() % 2000);
+        if (write(fd, command + split, len - split) < 0) {
+            perror("write");
+        }
+    }
+}
+
+/**
+ * Poll until the daemon answers, leaving its startup synchronization
+ */
+static int wait_for_daemon(int fd, const options_t *options) {
+    int64_t deadline_ns = now_ns() + STARTUP_TIMEOUT_MS * 1000000LL;
+    
+    while (now_ns() < deadline_ns) {
+        drain(fd);
+        send_poll(fd, options->binary, 0);
+        if (read_response(fd, options->binary, 100) == 1) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Poll at the given rate for the configured duration
+ */
+static void run(int fd, const options_t *options, int rate, run_stats_t *stats) {
+    int64_t start_ns = now_ns();
+    int64_t end_ns = start_ns + (int64_t)(options->duration_sec * 1e9);
+    int64_t period_ns = rate > 0 ? 1000000000LL / rate : 0;
+    int64_t next_ns = start_ns;
+    
+    memset(stats, 0, sizeof(*stats));
+    stats->capacity = rate > 0 ? (size_t)(rate * options->duration_sec) + 1 : 1000000;
+    stats->latencies_ms = malloc(stats->capacity * sizeof(double));
+    if (stats->latencies_ms == NULL) {
+        stats->capacity = 0;
+    }
+    
+    while (now_ns() < end_ns) {
+        if (period_ns > 0) {
+            sleep_until(next_ns);
+            next_ns += period_ns;
+        }
+        
+        drain(fd);
+        if (rand() % 100 < options->garbage_pct) {
+            send_garbage(fd);
+            stats->garbage_lines++;
+        }
+        int partial = rand() % 100 < options->partial_pct;
+        stats->partial_polls += partial;
+        
+        send_poll(fd, options->binary, partial);
+        int64_t sent_ns = now_ns();
+        int result = read_response(fd, options->binary, options->timeout_ms);
+        stats->polls++;
+        
+        if (result < 0) {
+            stats->timeouts++;
+            continue;
+        }
+        if (result == 0) {
+            stats->invalid++;
+            continue;
+        }
+        if (stats->answered < stats->capacity) {
+            stats->latencies_ms[stats->answered] = (now_ns() - sent_ns) / 1e6;
+        }
+        stats->answered++;
+    }
+    
+    stats->elapsed_sec = (now_ns() - start_ns) / 1e9;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t count, double pct) {
+    return count ? sorted[(size_t)((count - 1) * pct / 100.0 + 0.5)] : 0.0;
+}
+
+static void report(const run_stats_t *stats, int rate) {
+    size_t count = stats->answered < stats->capacity ? stats->answered : stats->capacity;
+    char label[16];
+    
+    qsort(stats->latencies_ms, count, sizeof(double), compare_double);
+    if (rate > 0) {
+        snprintf(label, sizeof(label), "%d", rate);
+    } else {
+        strcpy(label, "max");
+    }
+    
+    printf("rate %6s/s: %7lu POLLs (%.0f/s), %lu timeouts, %lu invalid, "
+           "latency p50 %.3fms p99 %.3fms p999 %.3fms max %.3fms\n",
+           label, stats->polls, stats->polls / stats->elapsed_sec,
+           stats->timeouts, stats->invalid,
+           percentile(stats->latencies_ms, count, 50), percentile(stats->latencies_ms, count, 99),
+           percentile(stats->latencies_ms, count, 99.9), count ? stats->latencies_ms[count - 1] : 0.0);
+}
+
+/**
+ * Run at increasing rates until POLLs time out, are answered wrongly, or fall behind
+ * Returns the highest rate sustained, 0 if none
+ */
+static int sweep(int fd, const options_t *options) {
+    int sustained = 0;
+    run_stats_t stats;
+    
+    for (size_t i = 0; i < sizeof(g_sweep_rates) / sizeof(g_sweep_rates[0]); i++) {
+        int rate = g_sweep_rates[i];
+        
+        run(fd, options, rate, &stats);
+        report(&stats, rate);
+        free(stats.latencies_ms);
+        
+        if (stats.timeouts > 0 || stats.invalid > 0 || stats.polls < 0.95 * rate * options->duration_sec) {
+            break;
+        }
+        sustained = rate;
+    }
+    
+    printf("maximum sustainable POLL rate: %d/s\n", sustained);
+    return sustained;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -D path   daemon to run (default: bin/fan_temp_daemon)\n"
+            "  -r rate   POLLs per second, 0 for back to back (default: 10)\n"
+            "  -d sec    duration of a run, or of each sweep step (default: 5)\n"
+            "  -b        poll with POLL:BIN\n"
+            "  -g pct    POLLs preceded by a garbage line (default: 0)\n"
+            "  -p pct    POLLs split across two writes (default: 0)\n"
+            "  -t ms     response timeout (default: %d)\n"
+            "  -s        sweep POLL rates to find the highest sustainable one\n"
+            "  -l        start the daemon with the low-latency serial profile\n"
+            "  -v        show the daemon's log\n",
+            name, RESPONSE_TIMEOUT_MS);
+}
+
+int main(int argc, char *argv[]) {
+    options_t options = {"bin/fan_temp_daemon", 10, 5.0, 0, 0, 0, RESPONSE_TIMEOUT_MS, 0, 0, 0};
+    int opt;
+    
+    while ((opt = getopt(argc, argv, "D:r:d:bg:p:t:slv")) != -1) {
+        switch (opt) {
+            case 'D': options.daemon_path = optarg; break;
+            case 'r': options.rate = atoi(optarg); break;
+            case 'd': options.duration_sec = atof(optarg); break;
+            case 'b': options.binary = 1; break;
+            case 'g': options.garbage_pct = atoi(optarg); break;
+            case 'p': options.partial_pct = atoi(optarg); break;
+            case 't': options.timeout_ms = atoi(optarg); break;
+            case 's': options.sweep = 1; break;
+            case 'l': options.low_latency = 1; break;
+            case 'v': options.verbose = 1; break;
+            default: usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+    if (options.rate < 0 || options.duration_sec <= 0 || options.timeout_ms <= 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    int master_fd, slave_fd;
+    char port[64];
+    struct termios tio;
+    
+    // The slave stays open here so the master never sees a hangup while the daemon reconnects
+    if (openpty(&master_fd, &slave_fd, port, NULL, NULL) != 0) {
+        perror("openpty");
+        return EXIT_FAILURE;
+    }
+    tcgetattr(master_fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(master_fd, TCSANOW, &tio);
+    fcntl(master_fd, F_SETFL, O_NONBLOCK);
+    fcntl(master_fd, F_SETFD, FD_CLOEXEC);
+    fcntl(slave_fd, F_SETFD, FD_CLOEXEC);
+    
+    if (create_sysfs() != 0) {
+        remove_sysfs();
+        return EXIT_FAILURE;
+    }
+    srand(1);
+    
+    pid_t pid = start_daemon(&options, port);
+    if (pid < 0) {
+        perror("fork");
+        remove_sysfs();
+        return EXIT_FAILURE;
+    }
+    
+    int failed = 0;
+    if (wait_for_daemon(master_fd, &options) != 0) {
+        fprintf(stderr, "%s did not answer on %s\n", options.daemon_path, port);
+        failed = 1;
+    } else if (options.sweep) {
+        failed = sweep(master_fd, &options) == 0;
+    } else {
+        run_stats_t stats;
+        run(master_fd, &options, options.rate, &stats);
+        report(&stats, options.rate);
+        free(stats.latencies_ms);
+        failed = stats.timeouts > 0 || stats.invalid > 0;
+    }
+    
+    // The daemon logs its own latency histograms on the way out (shown with -v)
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    remove_sysfs();
+    close(master_fd);
+    close(slave_fd);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+/**
+ * Line framer benchmark for Fan Temperature Daemon
+ * Feeds synthetic serial streams through the framer in read()-sized chunks
+ * and reports throughput, next to the previous memmove-based buffer
+ */
+
+#include "framer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STREAM_SIZE   (4 * 1024 * 1024)
+#define CHUNK_SIZE    63      // Bytes per read(), as in serial_read_available()
+#define ITERATIONS    8
+
+typedef struct {
+    const char *name;
+    void (*fill)(char *stream, size_t size);
+} stream_t;
+
+// Previous algorithm: linear buffer, shifted down by one byte per overflowing byte and after every line
+static char g_legacy_buffer[FRAMER_CAPACITY];
+static int g_legacy_pos = 0;
+
+static void legacy_push(const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (g_legacy_pos >= (int)sizeof(g_legacy_buffer) - 1) {
+            memmove(g_legacy_buffer, g_legacy_buffer + 1, sizeof(g_legacy_buffer) - 2);
+            g_legacy_pos = sizeof(g_legacy_buffer) - 2;
+        }
+        g_legacy_buffer[g_legacy_pos++] = data[i];
+    }
+    g_legacy_buffer[g_legacy_pos] = '\0';
+}
+
+static int legacy_next_line(char *line, size_t size) {
+    for (;;) {
+        char *newline = memchr(g_legacy_buffer, '\n', g_legacy_pos);
+        if (newline == NULL) {
+            return 0;
+        }
+        
+        int end = newline - g_legacy_buffer;
+        int len = end > 0 && g_legacy_buffer[end - 1] == '\r' ? end - 1 : end;
+        int found = len > 0 && (size_t)len < size;
+        if (found) {
+            memcpy(line, g_legacy_buffer, len);
+            line[len] = '\0';
+        }
+        
+        g_legacy_pos -= end + 1;
+        memmove(g_legacy_buffer, newline + 1, g_legacy_pos);
+        if (found) {
+            return len;
+        }
+    }
+}
+
+static void fill_clean(char *stream, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        stream[i] = "POLL\r\n"[i % 6];
+    }
+}
+
+static void fill_noisy(char *stream, size_t size) {
+    srand(1);
+    for (size_t i = 0; i < size; i++) {
+        int r = rand() % 64;
+        stream[i] = r == 0 ? '\n' : (char)(rand() & 0xff);
+    }
+}
+
+static void fill_no_newlines(char *stream, size_t size) {
+    srand(2);
+    for (size_t i = 0; i < size; i++) {
+        stream[i] = (char)('A' + rand() % 26);
+    }
+}
+
+static void fill_mixed(char *stream, size_t size) {
+    srand(3);
+    size_t i = 0;
+    while (i < size) {
+        const char *piece;
+        switch (rand() % 4) {
+            case 0:  piece = "POLL\r\n"; break;
+            case 1:  piece = "\r\n"; break;
+            case 2:  piece = "\x00\xff\x13POLL\n"; break;
+            default: piece = "CPU:55.00|NVME:48.00|AGE:12\r\n"; break;
+        }
+        for (size_t j = 0; piece[j] != '\0' && i < size; j++) {
+            stream[i++] = piece[j];
+        }
+    }
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double run_framer(const char *stream, size_t size, unsigned long *lines) {
+    framer_t framer;
+    char line[256];
+    
+    framer_init(&framer);
+    *lines = 0;
+    
+    double start = now_sec();
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        for (size_t pos = 0; pos < size; pos += CHUNK_SIZE) {
+            size_t len = size - pos < CHUNK_SIZE ? size - pos : CHUNK_SIZE;
+            framer_push(&framer, stream + pos, len);
+            while (framer_next_line(&framer, line, sizeof(line)) > 0) {
+                (*lines)++;
+            }
+        }
+    }
+    return now_sec() - start;
+}
+
+static double run_legacy(const char *stream, size_t size, unsigned long *lines) {
+    char line[256];
+    
+    g_legacy_pos = 0;
+    *lines = 0;
+    
+    double start = now_sec();
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        for (size_t pos = 0; pos < size; pos += CHUNK_SIZE) {
+            size_t len = size - pos < CHUNK_SIZE ? size - pos : CHUNK_SIZE;
+            legacy_push(stream + pos, len);
+            while (legacy_next_line(line, sizeof(line)) > 0) {
+                (*lines)++;
+            }
+        }
+    }
+    return now_sec() - start;
+}
+
+int main(void) {
+    static const stream_t streams[] = {
+        {"clean",       fill_clean},
+        {"noisy",       fill_noisy},
+        {"no-newlines", fill_no_newlines},
+        {"mixed",       fill_mixed},
+    };
+    
+    char *stream = malloc(STREAM_SIZE);
+    if (stream == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+    
+    printf("%-12s %-8s %12s %14s\n", "stream", "framer", "MB/s", "lines/s");
+    for (size_t i = 0; i < sizeof(streams) / sizeof(streams[0]); i++) {
+        unsigned long lines;
+        double total = (double)STREAM_SIZE * ITERATIONS;
+        
+        streams[i].fill(stream, STREAM_SIZE);
+        
+        double elapsed = run_framer(stream, STREAM_SIZE, &lines);
+        printf("%-12s %-8s %12.1f %14.0f\n", streams[i].name, "ring",
+               total / elapsed / 1e6, lines / elapsed);
+        
+        elapsed = run_legacy(stream, STREAM_SIZE, &lines);
+        printf("%-12s %-8s %12.1f %14.0f\n", streams[i].name, "memmove",
+               total / elapsed / 1e6, lines / elapsed);
+    }
+    
+    free(stream);
+    return EXIT_SUCCESS;
+}
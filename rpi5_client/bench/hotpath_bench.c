@@ -0,0 +1,398 @@
+/**
+ * Hot path benchmark for Fan Temperature Daemon
+ * Times each step a POLL or a sensor refresh goes through, over realistic inputs,
+ * with the CPU cycle counter where available, and compares reading a sensor
+ * through a spawned command, popen() and the native sysfs path
+ * Prints one JSON object per line so results of two builds can be diffed or joined
+ */
+
+#include "utils.h"
+#include "framer.h"
+#include "response.h"
+#include "temperature.h"
+#include "sensors.h"
+#include "command.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef BENCH_VERSION
+#define BENCH_VERSION "unknown"
+#endif
+
+#define ROUNDS          7           // Median of the rounds is reported
+#define FAST_OPS        200000      // Operations per round for in-process paths
+#define SENSOR_OPS      20000       // Native sensor reads per round
+#define SPAWN_OPS       50          // Commands per round
+
+// Cycle counter: perf counts core cycles on any architecture, the TSC is a fallback on x86
+typedef enum {
+    CYCLES_NONE = 0,
+    CYCLES_PERF,                // Including cycles spent in the kernel
+    CYCLES_PERF_USER,           // perf_event_paranoid only allows user space counting
+    CYCLES_TSC                  // Reference cycles at a constant rate
+} cycle_source_t;
+
+static const char *const g_cycle_source_names[] = {"none", "perf", "perf-user", "tsc"};
+
+static cycle_source_t g_cycle_source = CYCLES_NONE;
+static int g_perf_fd = -1;
+
+// Side effects the compiler must keep
+static volatile float g_sink_float;
+static volatile size_t g_sink_size;
+
+static char g_sysfs_root[] = "/tmp/hotpath_bench.XXXXXX";
+static char g_sensor_path[128];
+static char g_sensor_cmd[160];
+
+static int open_perf_cycles(int exclude_kernel) {
+    struct perf_event_attr attr;
+    
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = exclude_kernel;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void cycles_init(void) {
+    if ((g_perf_fd = open_perf_cycles(0)) >= 0) {
+        g_cycle_source = CYCLES_PERF;
+    } else if ((g_perf_fd = open_perf_cycles(1)) >= 0) {
+        g_cycle_source = CYCLES_PERF_USER;
+    } else {
+#if defined(__x86_64__) || defined(__i386__)
+        g_cycle_source = CYCLES_TSC;
+#endif
+        return;
+    }
+    ioctl(g_perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+static uint64_t cycles_now(void) {
+    uint64_t value = 0;
+    
+    if (g_perf_fd >= 0) {
+        if (read(g_perf_fd, &value, sizeof(value)) != sizeof(value)) {
+            value = 0;
+        }
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    else if (g_cycle_source == CYCLES_TSC) {
+        value = __rdtsc();
+    }
+#endif
+    return value;
+}
+
+typedef void (*bench_fn)(long ops);
+
+typedef struct {
+    const char *name;           // Function or path measured
+    const char *input;          // Input it is fed
+    bench_fn fn;
+    long ops;
+} bench_case_t;
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Run a case for ROUNDS rounds after a warm-up round and print its medians
+ */
+static void run_case(const bench_case_t *bench) {
+    double ns[ROUNDS];
+    double cycles[ROUNDS];
+    
+    bench->fn(bench->ops / 10 + 1);
+    
+    for (int round = 0; round < ROUNDS; round++) {
+        int64_t start_ns = utils_monotonic_ns();
+        uint64_t start_cycles = cycles_now();
+        bench->fn(bench->ops);
+        uint64_t end_cycles = cycles_now();
+        int64_t end_ns = utils_monotonic_ns();
+        
+        ns[round] = (double)(end_ns - start_ns) / bench->ops;
+        cycles[round] = (double)(end_cycles - start_cycles) / bench->ops;
+    }
+    
+    qsort(ns, ROUNDS, sizeof(double), compare_double);
+    qsort(cycles, ROUNDS, sizeof(double), compare_double);
+    
+    printf("{\"bench\":\"%s\",\"input\":\"%s\",\"ops\":%ld,\"rounds\":%d,"
+           "\"ns_per_op\":%.2f,\"min_ns_per_op\":%.2f,",
+           bench->name, bench->input, bench->ops, ROUNDS, ns[ROUNDS / 2], ns[0]);
+    if (g_cycle_source != CYCLES_NONE) {
+        printf("\"cycles_per_op\":%.1f,\"min_cycles_per_op\":%.1f}\n", cycles[ROUNDS / 2], cycles[0]);
+    } else {
+        printf("\"cycles_per_op\":null,\"min_cycles_per_op\":null}\n");
+    }
+    fflush(stdout);
+}
+
+/**
+ * Command received from the controller; the copy restores what the previous call stripped
+ */
+static void clean_buffer(const char *command, long ops) {
+    char buffer[64];
+    size_t len = strlen(command) + 1;
+    
+    for (long i = 0; i < ops; i++) {
+        memcpy(buffer, command, len);
+        utils_clean_buffer(buffer);
+        g_sink_size = buffer[0];
+    }
+}
+
+static void bench_clean_poll(long ops) {
+    clean_buffer("POLL\r\n", ops);
+}
+
+static void bench_clean_padded(long ops) {
+    clean_buffer("  PROTO:BIN \t\r\n", ops);
+}
+
+/**
+ * One POLL per read(), as the controller sends them
+ */
+static void bench_framer_poll(long ops) {
+    static framer_t framer;
+    char line[64];
+    
+    framer_init(&framer);
+    for (long i = 0; i < ops; i++) {
+        framer_push(&framer, "POLL\r\n", 6);
+        g_sink_size = framer_next_line(&framer, line, sizeof(line));
+    }
+}
+
+/**
+ * A POLL split across two reads, with noise before it
+ */
+static void bench_framer_noisy(long ops) {
+    static framer_t framer;
+    char line[64];
+    
+    framer_init(&framer);
+    for (long i = 0; i < ops; i++) {
+        framer_push(&framer, "\xff\x13PO", 4);
+        framer_push(&framer, "LL\r\n", 4);
+        g_sink_size = framer_next_line(&framer, line, sizeof(line));
+    }
+}
+
+static void make_snapshot(temperature_snapshot_t *snapshot, long sample) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->cpu_temp = 45.0f + (sample % 3000) * 0.01f;
+    snapshot->nvme_temp = 40.0f + (sample % 700) * 0.03f;
+    snapshot->cpu_slope = ((sample % 200) - 100) * 0.013f;
+    snapshot->cpu_load = (float)(sample % 101);
+    snapshot->timestamp_ns = sample;
+}
+
+/**
+ * POLL answered from an unchanged sample: only the age is written
+ */
+static void bench_response_cached(long ops) {
+    static response_t response;
+    temperature_snapshot_t snapshot;
+    
+    response_init(&response);
+    make_snapshot(&snapshot, 0);
+    for (long i = 0; i < ops; i++) {
+        response_update(&response, &snapshot, 1);
+        g_sink_size = response_set_age(&response, i % 1000);
+    }
+}
+
+/**
+ * POLL answered from a new sample every time: the response is re-encoded
+ */
+static void bench_response_changed(long ops) {
+    static response_t response;
+    temperature_snapshot_t snapshot;
+    
+    response_init(&response);
+    for (long i = 0; i < ops; i++) {
+        make_snapshot(&snapshot, i);
+        response_update(&response, &snapshot, 1);
+        g_sink_size = response_set_age(&response, i % 1000);
+    }
+}
+
+static void bench_response_frame(long ops) {
+    static response_t response;
+    temperature_snapshot_t snapshot;
+    
+    response_init(&response);
+    for (long i = 0; i < ops; i++) {
+        make_snapshot(&snapshot, i);
+        response_update(&response, &snapshot, 1);
+        g_sink_size = response_encode_frame(&response, i % 1000);
+    }
+}
+
+static void bench_parse_vcgencmd(long ops) {
+    float temp;
+    for (long i = 0; i < ops; i++) {
+        temperature_parse_cpu("temp=52.3'C\n", &temp);
+        g_sink_float = temp;
+    }
+}
+
+static void bench_parse_thermal_zone(long ops) {
+    float temp;
+    for (long i = 0; i < ops; i++) {
+        temperature_parse_cpu("52375\n", &temp);
+        g_sink_float = temp;
+    }
+}
+
+static void bench_parse_millidegrees(long ops) {
+    float temp;
+    for (long i = 0; i < ops; i++) {
+        temperature_parse_millidegrees("52375\n", &temp);
+        g_sink_float = temp;
+    }
+}
+
+static void bench_parse_smartctl(long ops) {
+    float temp;
+    for (long i = 0; i < ops; i++) {
+        temperature_parse_nvme_line("Temperature:                        41 Celsius", &temp);
+        g_sink_float = temp;
+    }
+}
+
+/**
+ * Native path: the sensor file stays open and is re-read with pread()
+ */
+static void bench_sensor_native(long ops) {
+    static sensor_group_t group;
+    float temp = 0;
+    
+    sensors_group_init(&group, "CPU", TEMP_AGGREGATE_MAX, 150.0f);
+    sensors_add(&group, "bench", g_sensor_path, SENSOR_KIND_MILLIDEGREE);
+    for (long i = 0; i < ops; i++) {
+        sensors_read(&group, &temp);
+        g_sink_float = temp;
+    }
+    sensors_close(&group);
+}
+
+/**
+ * Command path as the daemon runs it: posix_spawn under a deadline
+ */
+static void bench_sensor_spawn(long ops) {
+    static command_stats_t stats = {.name = "bench"};
+    char output[256];
+    float temp = 0;
+    
+    for (long i = 0; i < ops; i++) {
+        if (command_run(g_sensor_cmd, output, sizeof(output), 1000, &stats) > 0) {
+            temperature_parse_cpu(output, &temp);
+        }
+        g_sink_float = temp;
+    }
+}
+
+/**
+ * Command path before posix_spawn: popen() through the shell
+ */
+static void bench_sensor_popen(long ops) {
+    char output[256];
+    float temp = 0;
+    
+    for (long i = 0; i < ops; i++) {
+        FILE *pipe = popen(g_sensor_cmd, "r");
+        if (pipe == NULL) {
+            continue;
+        }
+        if (fgets(output, sizeof(output), pipe) != NULL) {
+            temperature_parse_cpu(output, &temp);
+        }
+        pclose(pipe);
+        g_sink_float = temp;
+    }
+}
+
+/**
+ * Sensor file in a temporary directory, so every machine reads the same input
+ */
+static int create_sensor(void) {
+    if (mkdtemp(g_sysfs_root) == NULL) {
+        perror("mkdtemp");
+        return -1;
+    }
+    
+    snprintf(g_sensor_path, sizeof(g_sensor_path), "%s/temp", g_sysfs_root);
+    snprintf(g_sensor_cmd, sizeof(g_sensor_cmd), "cat %s", g_sensor_path);
+    
+    FILE *file = fopen(g_sensor_path, "w");
+    if (file == NULL) {
+        perror(g_sensor_path);
+        return -1;
+    }
+    fputs("52375\n", file);
+    fclose(file);
+    return 0;
+}
+
+static void remove_sensor(void) {
+    unlink(g_sensor_path);
+    rmdir(g_sysfs_root);
+}
+
+int main(void) {
+    static const bench_case_t cases[] = {
+        {"utils_clean_buffer",            "POLL\\r\\n",                bench_clean_poll,         FAST_OPS},
+        {"utils_clean_buffer",            "padded PROTO:BIN",          bench_clean_padded,       FAST_OPS},
+        {"framer_next_line",              "POLL per read",             bench_framer_poll,        FAST_OPS},
+        {"framer_next_line",              "noisy POLL in two reads",   bench_framer_noisy,       FAST_OPS},
+        {"response_set_age",              "unchanged sample",          bench_response_cached,    FAST_OPS},
+        {"response_set_age",              "new sample per POLL",       bench_response_changed,   FAST_OPS},
+        {"response_encode_frame",         "new sample per POLL",       bench_response_frame,     FAST_OPS},
+        {"temperature_parse_cpu",         "vcgencmd",                  bench_parse_vcgencmd,     FAST_OPS},
+        {"temperature_parse_cpu",         "thermal_zone",              bench_parse_thermal_zone, FAST_OPS},
+        {"temperature_parse_millidegrees", "thermal_zone",             bench_parse_millidegrees, FAST_OPS},
+        {"temperature_parse_nvme_line",   "smartctl",                  bench_parse_smartctl,     FAST_OPS},
+        {"sensor_read",                   "native pread",              bench_sensor_native,      SENSOR_OPS},
+        {"sensor_read",                   "posix_spawn cat",           bench_sensor_spawn,       SPAWN_OPS},
+        {"sensor_read",                   "popen cat",                 bench_sensor_popen,       SPAWN_OPS},
+    };
+    
+    if (create_sensor() != 0) {
+        remove_sensor();
+        return EXIT_FAILURE;
+    }
+    cycles_init();
+    
+    printf("{\"bench\":\"meta\",\"version\":\"%s\",\"cycles\":\"%s\",\"cpus\":%ld}\n",
+           BENCH_VERSION, g_cycle_source_names[g_cycle_source], sysconf(_SC_NPROCESSORS_ONLN));
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        run_case(&cases[i]);
+    }
+    
+    if (g_perf_fd >= 0) {
+        close(g_perf_fd);
+    }
+    remove_sensor();
+    return EXIT_SUCCESS;
+}
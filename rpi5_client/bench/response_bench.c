@@ -0,0 +1,195 @@
+/**
+ * Response encoding benchmark for Fan Temperature Daemon
+ * Measures the per-POLL CPU cost of building and writing the response:
+ * snprintf("%.2f") + strlen + write() as before, against the cached
+ * fixed-point response + writev(), both written to /dev/null, and the
+ * binary frame sent for POLL:BIN
+ */
+
+#include "response.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#define POLLS 2000000
+
+// Previous response path, without the configuration lookup
+static int legacy_format(char *buffer, size_t size, const temperature_snapshot_t *snapshot, long age_ms) {
+    int len = snprintf(buffer, size, "CPU:%.2f|NVME:%.2f|AGE:%ld",
+                       snapshot->cpu_temp, snapshot->nvme_temp, age_ms);
+    
+    len += snprintf(buffer + len, size - len, "|DCPU:%.2f|DNVME:%.2f",
+                    snapshot->cpu_slope, snapshot->nvme_slope);
+    
+    if (snapshot->cpu_load >= 0) {
+        len += snprintf(buffer + len, size - len, "|LOAD:%.0f", snapshot->cpu_load);
+    }
+    
+    len += snprintf(buffer + len, size - len, "\n");
+    return len;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Snapshot for POLL i; a new sample every change_every POLLs
+static void make_snapshot(temperature_snapshot_t *snapshot, int i, int change_every) {
+    int sample = i / change_every;
+    
+    snapshot->cpu_temp = 45.0f + (sample % 3000) * 0.01f;
+    snapshot->nvme_temp = 40.0f + (sample % 700) * 0.03f;
+    snapshot->cpu_slope = ((sample % 200) - 100) * 0.013f;
+    snapshot->nvme_slope = 0.0f;
+    snapshot->cpu_load = (float)(sample % 101);
+    snapshot->timestamp_ns = sample;
+}
+
+static double run_legacy(int fd, int change_every) {
+    temperature_snapshot_t snapshot;
+    char buffer[128];
+    
+    double start = now_sec();
+    for (int i = 0; i < POLLS; i++) {
+        make_snapshot(&snapshot, i, change_every);
+        legacy_format(buffer, sizeof(buffer), &snapshot, i % 1000);
+        if (write(fd, buffer, strlen(buffer)) < 0) {
+            return -1;
+        }
+    }
+    return (now_sec() - start) / POLLS;
+}
+
+static double run_cached(int fd, int change_every) {
+    temperature_snapshot_t snapshot;
+    response_t response;
+    
+    response_init(&response);
+    
+    double start = now_sec();
+    for (int i = 0; i < POLLS; i++) {
+        make_snapshot(&snapshot, i, change_every);
+        response_update(&response, &snapshot, 1);
+        response_set_age(&response, i % 1000);
+        if (writev(fd, response.iov, RESPONSE_IOV_COUNT) < 0) {
+            return -1;
+        }
+    }
+    return (now_sec() - start) / POLLS;
+}
+
+static double run_binary(int fd, int change_every) {
+    temperature_snapshot_t snapshot;
+    response_t response;
+    
+    response_init(&response);
+    
+    double start = now_sec();
+    for (int i = 0; i < POLLS; i++) {
+        make_snapshot(&snapshot, i, change_every);
+        response_update(&response, &snapshot, 1);
+        response_set_age(&response, i % 1000);
+        size_t len = response_encode_frame(&response, i % 1000);
+        if (write(fd, response.frame, len) < 0) {
+            return -1;
+        }
+    }
+    return (now_sec() - start) / POLLS;
+}
+
+/**
+ * Check that binary frames decode to the values of the text response
+ * Also reports the average length of both encodings
+ */
+static int count_frame_mismatches(int samples, double *text_bytes, double *frame_bytes) {
+    temperature_snapshot_t snapshot;
+    response_t response;
+    wire_temperatures_t values;
+    int mismatches = 0;
+    
+    *text_bytes = 0;
+    *frame_bytes = 0;
+    response_init(&response);
+    for (int i = 0; i < samples; i++) {
+        make_snapshot(&snapshot, i, 1);
+        response_update(&response, &snapshot, 1);
+        *text_bytes += response_set_age(&response, i % 1000);
+        size_t len = response_encode_frame(&response, i % 1000);
+        *frame_bytes += len;
+        
+        if (response.frame[len - 1] != 0 || memchr(response.frame, 0, len - 1) != NULL ||
+            wire_decode_temperatures(response.frame, len - 1, &values) != 0 ||
+            values.cpu_centi != response.cpu_centi || values.nvme_centi != response.nvme_centi ||
+            values.cpu_slope_centi != response.cpu_slope_centi ||
+            values.nvme_slope_centi != response.nvme_slope_centi ||
+            values.load_pct != response.load_pct || values.age_ms != i % 1000) {
+            mismatches++;
+        }
+    }
+    *text_bytes /= samples;
+    *frame_bytes /= samples;
+    return mismatches;
+}
+
+/**
+ * Check that both encoders produce the same bytes
+ */
+static int count_mismatches(int samples) {
+    temperature_snapshot_t snapshot;
+    response_t response;
+    char legacy[128];
+    char cached[128];
+    int mismatches = 0;
+    
+    response_init(&response);
+    for (int i = 0; i < samples; i++) {
+        make_snapshot(&snapshot, i, 1);
+        legacy_format(legacy, sizeof(legacy), &snapshot, i % 1000);
+        
+        response_update(&response, &snapshot, 1);
+        size_t len = response_set_age(&response, i % 1000);
+        size_t pos = 0;
+        for (int v = 0; v < RESPONSE_IOV_COUNT; v++) {
+            memcpy(cached + pos, response.iov[v].iov_base, response.iov[v].iov_len);
+            pos += response.iov[v].iov_len;
+        }
+        cached[len] = '\0';
+        
+        if (strcmp(legacy, cached) != 0) {
+            if (mismatches++ < 3) {
+                printf("mismatch: %s   vs %s", legacy, cached);
+            }
+        }
+    }
+    return mismatches;
+}
+
+int main(void) {
+    static const int change_every[] = {1, 10, 100};
+    
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        perror("/dev/null");
+        return EXIT_FAILURE;
+    }
+    
+    double text_bytes, frame_bytes;
+    printf("encoding mismatches: %d of 100000\n", count_mismatches(100000));
+    printf("binary frame mismatches: %d of 100000\n", count_frame_mismatches(100000, &text_bytes, &frame_bytes));
+    printf("average response: %.1f bytes as text, %.1f bytes as binary frame\n", text_bytes, frame_bytes);
+    printf("%-22s %12s %12s %12s\n", "new sample every", "before ns", "after ns", "binary ns");
+    for (size_t i = 0; i < sizeof(change_every) / sizeof(change_every[0]); i++) {
+        double legacy = run_legacy(fd, change_every[i]);
+        double cached = run_cached(fd, change_every[i]);
+        double binary = run_binary(fd, change_every[i]);
+        printf("%-4d POLLs %11s %12.1f %12.1f %12.1f\n", change_every[i], "", legacy * 1e9, cached * 1e9, binary * 1e9);
+    }
+    
+    close(fd);
+    return EXIT_SUCCESS;
+}
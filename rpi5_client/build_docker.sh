@@ -5,13 +5,14 @@ set -e
 echo "Building fan_temp_daemon for Raspberry Pi 5 using Docker..."
 
 # Build Docker image and compile the daemon
-docker build --platform linux/arm64 --progress=plain -t rpi5-fan-daemon-builder .
+# The repository root is the build context: the daemon builds lib/wire_protocol from there
+docker build --platform linux/arm64 --progress=plain -t rpi5-fan-daemon-builder -f Dockerfile ..
 
 # Create a temporary container to extract the binary
 CONTAINER_ID=$(docker create --platform linux/arm64 rpi5-fan-daemon-builder)
 
 # Copy the compiled .deb package from the container
-docker cp $CONTAINER_ID:/build/rpi5-fan-temp-daemon-1.0.0.deb ./rpi5-fan-temp-daemon-1.0.0.deb
+docker cp $CONTAINER_ID:/build/rpi5_client/rpi5-fan-temp-daemon-1.0.0.deb ./rpi5-fan-temp-daemon-1.0.0.deb
 
 # Clean up the temporary container
 docker rm $CONTAINER_ID
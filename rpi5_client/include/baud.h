@@ -0,0 +1,12 @@
+#ifndef BAUD_H
+#define BAUD_H
+
+#define BAUD_MIN        50
+#define BAUD_MAX        4000000
+#define BAUD_TOLERANCE  3       // Percent the applied rate may deviate from the requested one
+
+// Function prototypes
+int baud_set(int fd, int rate);
+int baud_get(int fd, int *rate);
+
+#endif // BAUD_H
@@ -0,0 +1,27 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define COMMAND_STATS_WINDOW 256   // Latency samples kept for percentiles
+
+// Per-command latency statistics
+typedef struct {
+    const char *name;
+    int64_t samples_ns[COMMAND_STATS_WINDOW];
+    size_t sample_count;
+    size_t next_sample;
+    unsigned long runs;
+    unsigned long timeouts;
+    unsigned long failures;
+    int64_t max_ns;
+} command_stats_t;
+
+// Function prototypes
+pid_t command_spawn(const char *cmd, int *stdout_fd);
+int command_run(const char *cmd, char *output, size_t size, int deadline_ms, command_stats_t *stats);
+void command_log_stats(const command_stats_t *stats);
+
+#endif // COMMAND_H
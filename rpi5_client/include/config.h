@@ -1,8 +1,6 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-#include <termios.h>
-
 // Environment variable names
 #define ENV_SERIAL_PORT     "FAN_TEMP_SERIAL_PORT"
 #define ENV_BAUD_RATE       "FAN_TEMP_BAUD_RATE"
@@ -13,16 +11,94 @@
 #define ENV_FOREGROUND      "FAN_TEMP_FOREGROUND"
 #define ENV_VERBOSE         "FAN_TEMP_VERBOSE"
 
+// Optional environment variables
+#define ENV_CPU_SOURCE      "FAN_TEMP_CPU_SOURCE"
+#define ENV_CPU_SENSOR      "FAN_TEMP_CPU_SENSOR"
+#define ENV_NVME_SOURCE     "FAN_TEMP_NVME_SOURCE"
+#define ENV_NVME_DEVICE     "FAN_TEMP_NVME_DEVICE"
+#define ENV_SYSFS_ROOT      "FAN_TEMP_SYSFS_ROOT"
+#define ENV_PROC_ROOT       "FAN_TEMP_PROC_ROOT"
+#define ENV_CPU_INTERVAL    "FAN_TEMP_CPU_INTERVAL_MS"
+#define ENV_NVME_INTERVAL   "FAN_TEMP_NVME_INTERVAL_MS"
+#define ENV_CMD_TIMEOUT     "FAN_TEMP_CMD_TIMEOUT_MS"
+#define ENV_COPROC_MAX_AGE  "FAN_TEMP_COPROC_MAX_AGE_MS"
+#define ENV_CPU_AGGREGATE   "FAN_TEMP_CPU_AGGREGATE"
+#define ENV_NVME_AGGREGATE  "FAN_TEMP_NVME_AGGREGATE"
+#define ENV_SENSOR_WEIGHTS  "FAN_TEMP_SENSOR_WEIGHTS"
+#define ENV_TREND_SAMPLES   "FAN_TEMP_TREND_SAMPLES"
+#define ENV_SERIAL_DRAIN    "FAN_TEMP_SERIAL_DRAIN"
+#define ENV_BAUD_MAX        "FAN_TEMP_BAUD_MAX"
+#define ENV_LOW_LATENCY     "FAN_TEMP_LOW_LATENCY"
+#define ENV_PUSH_DELTA      "FAN_TEMP_PUSH_DELTA"
+#define ENV_PUSH_HEARTBEAT  "FAN_TEMP_PUSH_HEARTBEAT_MS"
+#define ENV_METRICS_SOCKET  "FAN_TEMP_METRICS_SOCKET"
+#define ENV_METRICS_TEXTFILE "FAN_TEMP_METRICS_TEXTFILE"
+#define ENV_METRICS_INTERVAL "FAN_TEMP_METRICS_INTERVAL_MS"
+
+// Defaults for optional settings
+#define DEFAULT_NVME_DEVICE "/dev/nvme0"
+#define DEFAULT_SYSFS_ROOT  "/sys"
+#define DEFAULT_PROC_ROOT   "/proc"
+#define DEFAULT_CPU_INTERVAL_MS  250
+#define DEFAULT_NVME_INTERVAL_MS 10000
+#define DEFAULT_CMD_TIMEOUT_MS   1000
+#define DEFAULT_COPROC_MAX_AGE_MS 10000
+#define DEFAULT_TREND_SAMPLES    8
+#define DEFAULT_BAUD_MAX         1000000
+#define DEFAULT_PUSH_DELTA       0.5f
+#define DEFAULT_PUSH_HEARTBEAT_MS 10000
+#define PUSH_HEARTBEAT_MIN_MS    100
+#define PUSH_HEARTBEAT_MAX_MS    60000
+#define DEFAULT_METRICS_INTERVAL_MS 15000
+#define METRICS_INTERVAL_MIN_MS  1000
+#define METRICS_INTERVAL_MAX_MS  3600000
+
+// Temperature source selection
+typedef enum {
+    TEMP_SOURCE_AUTO = 0,   // Native backend, command as fallback
+    TEMP_SOURCE_NATIVE,     // Native backend only
+    TEMP_SOURCE_CMD,        // External command only
+    TEMP_SOURCE_COPROC      // Long-lived command writing one reading per line
+} temp_source_t;
+
+// Aggregation of a sensor group into one reported temperature
+typedef enum {
+    TEMP_AGGREGATE_MAX = 0, // Hottest sensor
+    TEMP_AGGREGATE_MEAN     // Weighted mean of all sensors
+} temp_aggregate_t;
+
 // Configuration structure
 typedef struct {
     char *serial_port;
-    speed_t baud_rate;
+    int baud_rate;              // Bits per second, also the rate negotiation starts from
+    int baud_max;               // Highest rate the controller may negotiate, 0 disables negotiation
     int read_timeout_sec;
     int log_to_syslog;
     char *cpu_temp_cmd;
     char *nvme_temp_cmd;
     int foreground;
     int verbose;
+    temp_source_t cpu_source;
+    char *cpu_sensor_path;
+    temp_source_t nvme_source;
+    char *nvme_device;
+    char *sysfs_root;
+    char *proc_root;
+    int cpu_interval_ms;
+    int nvme_interval_ms;
+    int cmd_timeout_ms;
+    int coproc_max_age_ms;      // Coprocess readings older than this are reported as failed reads
+    temp_aggregate_t cpu_aggregate;
+    temp_aggregate_t nvme_aggregate;
+    char *sensor_weights;
+    int trend_samples;
+    int serial_drain;
+    int low_latency;            // ASYNC_LOW_LATENCY on the UART driver
+    float push_delta;           // Temperature change that triggers a push update, 0 disables push mode
+    int push_heartbeat_ms;      // Longest interval between push updates
+    char *metrics_socket;       // Unix socket serving the metrics, NULL if disabled
+    char *metrics_textfile;     // node_exporter textfile rewritten with the metrics, NULL if disabled
+    int metrics_interval_ms;    // Textfile rewrite interval
 } config_t;
 
 // Global configuration instance
@@ -32,7 +108,9 @@ extern config_t g_config;
 int config_load_from_env(void);
 void config_cleanup(void);
 int config_validate(void);
-speed_t config_parse_baud_rate(const char *baud_str);
+int config_parse_baud_rate(const char *baud_str);
+int config_parse_source(const char *source_str);
+int config_parse_aggregate(const char *aggregate_str);
 void config_print_usage(void);
 
 #endif // CONFIG_H
@@ -0,0 +1,35 @@
+#ifndef COPROCESS_H
+#define COPROCESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Parser for one line of coprocess output
+typedef int (*coprocess_parse_fn)(const char *line, float *value);
+
+// Long-lived sensor command writing one reading per line
+typedef struct {
+    const char *name;
+    const char *cmd;
+    coprocess_parse_fn parse;
+    pid_t pid;
+    int fd;                     // Non-blocking read end of the child's stdout
+    char line[128];             // Partial line accumulated between reads
+    size_t line_len;
+    float value;
+    int has_value;
+    int64_t value_ns;           // When value was read
+    int max_age_ms;             // Older values are not reported
+    int64_t started_ns;
+    int64_t restart_at_ns;
+    int backoff_ms;
+    unsigned long restarts;
+} coprocess_t;
+
+// Function prototypes
+int coprocess_start(coprocess_t *cp, const char *name, const char *cmd, coprocess_parse_fn parse, int max_age_ms);
+int coprocess_poll(coprocess_t *cp, float *value);
+void coprocess_stop(coprocess_t *cp);
+
+#endif // COPROCESS_H
@@ -1,12 +1,14 @@
 #ifndef DAEMON_H
 #define DAEMON_H
 
+#include <signal.h>
+
 // Global control variables
 extern volatile int g_running;
 
 // Function prototypes
 void daemon_daemonize(void);
-void daemon_setup_signals(void);
+void daemon_setup_signals(sigset_t *signals);
 void daemon_cleanup(void);
 void daemon_signal_handler(int sig);
 
@@ -0,0 +1,26 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdint.h>
+#include <signal.h>
+
+#define EVENT_LOOP_MAX_SOURCES 16
+
+// Called from the loop when fd is ready; events are EPOLL* flags
+typedef void (*event_handler_fn)(int fd, uint32_t events, void *data);
+
+// Function prototypes
+int event_loop_init(void);
+void event_loop_cleanup(void);
+int event_loop_add(int fd, uint32_t events, event_handler_fn handler, void *data);
+int event_loop_modify(int fd, uint32_t events);
+void event_loop_remove(int fd);
+int event_loop_add_timer(event_handler_fn handler, void *data);
+int event_loop_arm_timer(int timer_fd, int delay_ms, int interval_ms);
+uint64_t event_loop_read_timer(int timer_fd);
+int event_loop_add_signals(const sigset_t *signals, event_handler_fn handler, void *data);
+int event_loop_read_signal(int signal_fd);
+void event_loop_run(void);
+void event_loop_stop(void);
+
+#endif // EVENT_LOOP_H
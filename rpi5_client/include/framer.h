@@ -0,0 +1,23 @@
+#ifndef FRAMER_H
+#define FRAMER_H
+
+#include <stddef.h>
+
+#define FRAMER_CAPACITY 512
+
+// Circular buffer splitting a byte stream into newline terminated lines
+typedef struct {
+    char data[FRAMER_CAPACITY];
+    size_t head;                // Offset of the oldest buffered byte
+    size_t len;                 // Buffered bytes
+    size_t scanned;             // Leading bytes already known to hold no '\n'
+    unsigned long overflow_bytes;
+    unsigned long skipped_lines;
+} framer_t;
+
+// Function prototypes
+void framer_init(framer_t *framer);
+void framer_push(framer_t *framer, const char *data, size_t len);
+int framer_next_line(framer_t *framer, char *line, size_t size);
+
+#endif // FRAMER_H
@@ -0,0 +1,17 @@
+#ifndef HOTPLUG_H
+#define HOTPLUG_H
+
+#define HOTPLUG_MAX_DEPTH 8
+
+// What happened to the watched device path
+#define HOTPLUG_CREATED  0x1    // Path or one of its directories was created or moved in
+#define HOTPLUG_REMOVED  0x2    // Path or one of its directories was removed or moved away
+#define HOTPLUG_CHANGED  0x4    // Attributes changed, e.g. udev adjusting permissions
+
+// Function prototypes
+int hotplug_init(const char *path);
+int hotplug_read(int fd);
+int hotplug_device_present(void);
+void hotplug_cleanup(void);
+
+#endif // HOTPLUG_H
@@ -0,0 +1,34 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+#define LATENCY_SUB_BITS    4       // 16 buckets per power of two: values kept within 1/16
+#define LATENCY_MAX_BITS    40      // Values up to 2^40ns (18 minutes), longer ones are clamped
+#define LATENCY_BUCKETS     ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+// Points in the handling of one POLL, in order
+typedef enum {
+    LATENCY_RECEIVED = 0,   // Bytes completing the command read from the port
+    LATENCY_PARSED,         // Command extracted from the receive buffer
+    LATENCY_SAMPLED,        // Sensor snapshot taken from the sampler
+    LATENCY_FORMATTED,      // Response encoded
+    LATENCY_WRITTEN,        // Response written, or transmitted when draining
+    LATENCY_POINTS
+} latency_point_t;
+
+// Log-bucketed histogram of durations, fixed size so recording never allocates
+typedef struct {
+    uint32_t counts[LATENCY_BUCKETS];
+    uint64_t total;
+    int64_t max_ns;
+} latency_histogram_t;
+
+// Function prototypes
+void latency_record(latency_histogram_t *histogram, int64_t value_ns);
+int64_t latency_percentile(const latency_histogram_t *histogram, double percentile);
+void latency_mark(latency_point_t point);
+void latency_complete(void);
+void latency_log_stats(void);
+
+#endif // LATENCY_H
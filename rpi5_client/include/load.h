@@ -0,0 +1,9 @@
+#ifndef LOAD_H
+#define LOAD_H
+
+// Function prototypes
+int load_init(void);
+void load_cleanup(void);
+float load_get_utilization(void);
+
+#endif // LOAD_H
@@ -5,6 +5,8 @@
 
 // Function prototypes
 int logger_init(int use_syslog);
+int logger_start(void);
+void logger_stop(void);
 void logger_cleanup(void);
 void logger_log(int priority, const char *format, ...);
 
@@ -0,0 +1,64 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// Counters and gauges exported for monitoring
+typedef enum {
+    // Counters, incremented where the event happens
+    METRIC_POLLS = 0,               // POLL and POLL:BIN commands answered
+    METRIC_POLLS_COALESCED,         // Duplicate POLLs folded into one response
+    METRIC_UNKNOWN_COMMANDS,
+    METRIC_PUSH_UPDATES,            // Push updates sent
+    METRIC_PUSH_REPEATS,            // Push updates repeated for lack of an ACK
+    METRIC_BYTES_RECEIVED,
+    METRIC_BYTES_SENT,
+    METRIC_SERIAL_ERRORS,           // Failed reads and hangups
+    METRIC_SERIAL_TIMEOUTS,         // Read timeouts without any data
+    METRIC_RECONNECTS,
+    METRIC_BAUD_FALLBACKS,          // Returns to the configured rate after silence
+    METRIC_SENSOR_REFRESHES,        // Sensor cache misses that read a sensor
+    METRIC_SENSOR_ERRORS,           // Readings that failed, last good value reported
+    METRIC_LOG_DROPS,               // Log records dropped because the log ring was full
+    
+    // Gauges, set from the event loop before each export
+    METRIC_CONNECTED,
+    METRIC_BAUD_RATE,
+    METRIC_CONSECUTIVE_ERRORS,
+    METRIC_CONSECUTIVE_TIMEOUTS,
+    METRIC_SUCCESSFUL_EXCHANGES,
+    METRIC_PUSH_ACTIVE,
+    METRIC_CPU_MILLIDEGREES,
+    METRIC_NVME_MILLIDEGREES,
+    METRIC_COUNT
+} metric_id_t;
+
+// Metric values; updates are relaxed atomics so any thread can feed them without locking
+extern _Atomic int64_t g_metrics[METRIC_COUNT];
+
+static inline void metrics_add(metric_id_t id, int64_t value) {
+    atomic_fetch_add_explicit(&g_metrics[id], value, memory_order_relaxed);
+}
+
+static inline void metrics_inc(metric_id_t id) {
+    atomic_fetch_add_explicit(&g_metrics[id], 1, memory_order_relaxed);
+}
+
+static inline void metrics_set(metric_id_t id, int64_t value) {
+    atomic_store_explicit(&g_metrics[id], value, memory_order_relaxed);
+}
+
+static inline int64_t metrics_get(metric_id_t id) {
+    return atomic_load_explicit(&g_metrics[id], memory_order_relaxed);
+}
+
+// Function prototypes
+size_t metrics_format(char *buffer, size_t size);
+int metrics_listen(const char *path);
+void metrics_serve(int listen_fd);
+int metrics_write_textfile(const char *path);
+void metrics_close(int listen_fd, const char *path);
+
+#endif // METRICS_H
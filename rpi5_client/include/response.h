@@ -0,0 +1,48 @@
+#ifndef RESPONSE_H
+#define RESPONSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+#include "sampler.h"
+#include "wire_protocol.h"
+
+// Reported sample age is capped to keep the response within the controller's limits
+#define RESPONSE_MAX_AGE_MS      99999
+#define RESPONSE_MAX_SLOPE_CENTI 9999     // 99.99 degrees per second
+#define RESPONSE_MAX_TEMP_CENTI  999999   // 9999.99 degrees, bounds the encoded width
+#define RESPONSE_IOV_COUNT       3
+
+// Format of a POLL response
+typedef enum {
+    RESPONSE_TEXT = 0,          // CPU, NVME and AGE only: fits the 32 bytes older controllers accept
+    RESPONSE_TEXT_EXTENDED,     // With the trend and load fields (POLL:EXT, text push updates)
+    RESPONSE_BINARY             // Binary temperatures frame (POLL:BIN)
+} response_format_t;
+
+// POLL response kept encoded between samples; only the age is written per POLL
+typedef struct {
+    int valid;
+    int with_trend;
+    long cpu_centi;             // Values the cached bytes encode, in hundredths
+    long nvme_centi;
+    long cpu_slope_centi;
+    long nvme_slope_centi;
+    long load_pct;              // Negative when the LOAD field is omitted
+    char head[32];              // "CPU:<t>|NVME:<t>|AGE:"
+    char age[8];
+    char tail[48];              // "[|DCPU:<s>|DNVME:<s>][|LOAD:<pct>]\n"
+    struct iovec iov[RESPONSE_IOV_COUNT];
+    size_t length;
+    uint8_t frame[WIRE_MAX_FRAME];   // Binary temperatures frame for POLL:BIN
+    size_t frame_length;
+    unsigned long encodes;
+} response_t;
+
+// Function prototypes
+void response_init(response_t *response);
+int response_update(response_t *response, const temperature_snapshot_t *snapshot, int with_trend);
+size_t response_set_age(response_t *response, long age_ms);
+size_t response_encode_frame(response_t *response, long age_ms);
+
+#endif // RESPONSE_H
@@ -0,0 +1,23 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdint.h>
+
+// Latest sensor readings as published by the sampler thread
+typedef struct {
+    float cpu_temp;
+    float nvme_temp;
+    float cpu_slope;        // Temperature trend in degrees per second
+    float nvme_slope;
+    float cpu_load;         // CPU utilization in percent, negative when not available
+    int64_t timestamp_ns;   // CLOCK_MONOTONIC time the sample was taken
+} temperature_snapshot_t;
+
+// Function prototypes
+int sampler_start(void);
+void sampler_stop(void);
+void sampler_get_snapshot(temperature_snapshot_t *snapshot);
+long sampler_snapshot_age_ms(const temperature_snapshot_t *snapshot);
+int sampler_notify_fd(void);
+
+#endif // SAMPLER_H
@@ -0,0 +1,43 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include "config.h"
+
+#define SENSORS_MAX_PER_GROUP 16
+
+// How a sensor is read
+typedef enum {
+    SENSOR_KIND_MILLIDEGREE = 0,    // sysfs file holding millidegrees, read with pread()
+    SENSOR_KIND_NVME_IOCTL          // NVME device, SMART/Health log page admin command
+} sensor_kind_t;
+
+// One native temperature sensor with its file kept open
+typedef struct {
+    char label[32];
+    char path[256];
+    sensor_kind_t kind;
+    int fd;
+    float weight;
+    float value;
+} sensor_t;
+
+// Sensors aggregated into a single reported temperature
+typedef struct {
+    const char *name;
+    temp_aggregate_t aggregate;
+    float max_valid;                // Readings outside (0, max_valid) are ignored
+    sensor_t sensors[SENSORS_MAX_PER_GROUP];
+    int count;
+} sensor_group_t;
+
+// Function prototypes
+void sensors_group_init(sensor_group_t *group, const char *name, temp_aggregate_t aggregate, float max_valid);
+int sensors_add(sensor_group_t *group, const char *label, const char *path, sensor_kind_t kind);
+int sensors_add_paths(sensor_group_t *group, const char *paths);
+int sensors_discover_cpu(sensor_group_t *group);
+int sensors_discover_nvme(sensor_group_t *group);
+int sensors_read(sensor_group_t *group, float *temp);
+void sensors_log_group(sensor_group_t *group);
+void sensors_close(sensor_group_t *group);
+
+#endif // SENSORS_H
@@ -1,14 +1,47 @@
 #ifndef SERIAL_H
 #define SERIAL_H
 
-#include <termios.h>
 #include <stddef.h>
+#include <sys/uio.h>
+
+#define SERIAL_BATCH_MAX    16
+#define SERIAL_COMMAND_MAX  64
+
+// Commands understood by the daemon
+typedef enum {
+    SERIAL_COMMAND_POLL = 0,
+    SERIAL_COMMAND_POLL_EXTENDED, // POLL:EXT, answered with the trend and load fields as well
+    SERIAL_COMMAND_POLL_BINARY, // POLL:BIN, answered with a binary temperatures frame
+    SERIAL_COMMAND_PROTO,       // PROTO:<format>, wire format negotiation
+    SERIAL_COMMAND_BAUD,        // BAUD:<rate> or BAUD:COMMIT, baud rate negotiation
+    SERIAL_COMMAND_ECHO,        // ECHO:<pattern>, line test at a negotiated rate
+    SERIAL_COMMAND_PUSH,        // PUSH:ON, PUSH:BIN or PUSH:OFF, push mode control
+    SERIAL_COMMAND_ACK,         // ACK, the controller received a push update
+    SERIAL_COMMAND_UNKNOWN
+} serial_command_type_t;
+
+// One parsed command from the fan controller
+typedef struct {
+    serial_command_type_t type;
+    char text[SERIAL_COMMAND_MAX];
+} serial_command_t;
+
+// Commands received in one wakeup
+typedef struct {
+    serial_command_t commands[SERIAL_BATCH_MAX];
+    int count;
+    int coalesced;              // Duplicate POLLs folded into the first one
+} serial_batch_t;
 
 // Function prototypes
-int serial_setup(const char *port, speed_t baud_rate);
+int serial_setup(const char *port, int baud_rate);
+int serial_set_baud(int fd, int baud_rate);
 int serial_send_data(int fd, const char *data);
-int serial_read_data(int fd, char *buffer, size_t size, int timeout_sec);
-int serial_read_complete_command(int fd, char *buffer, size_t size, int timeout_sec);
+int serial_send_iov(int fd, const struct iovec *iov, int count);
+int serial_push_iov(int fd, const struct iovec *iov, int count);
+int serial_read_available(int fd);
+int serial_next_command(char *buffer, size_t size);
+int serial_next_batch(serial_batch_t *batch);
 void serial_clear_buffers(int fd);
 int serial_check_health(int fd);
 void serial_recover_synchronization(int fd);
@@ -4,8 +4,13 @@
 #include <stddef.h>
 
 // Function prototypes
-float temperature_get_cpu(const char *cmd);
-float temperature_get_nvme(const char *cmd);
-int temperature_format_response(char *buffer, size_t size, float cpu_temp, float nvme_temp);
+int temperature_init(void);
+void temperature_cleanup(void);
+void temperature_log_command_stats(void);
+int temperature_get_cpu(const char *cmd, float *temp);
+int temperature_get_nvme(const char *cmd, float *temp);
+int temperature_parse_cpu(const char *text, float *temp);
+int temperature_parse_millidegrees(const char *text, float *temp);
+int temperature_parse_nvme_line(const char *line, float *temp);
 
 #endif // TEMPERATURE_H
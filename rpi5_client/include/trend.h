@@ -0,0 +1,22 @@
+#ifndef TREND_H
+#define TREND_H
+
+#include <stdint.h>
+
+#define TREND_MAX_SAMPLES 32   // Upper limit of the regression window
+
+// Ring buffer of recent readings of one sensor
+typedef struct {
+    int64_t times_ns[TREND_MAX_SAMPLES];
+    float values[TREND_MAX_SAMPLES];
+    int capacity;
+    int count;
+    int next;
+} trend_t;
+
+// Function prototypes
+void trend_init(trend_t *trend, int capacity);
+void trend_add(trend_t *trend, int64_t time_ns, float value);
+float trend_slope(const trend_t *trend);
+
+#endif // TREND_H
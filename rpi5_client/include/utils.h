@@ -2,9 +2,11 @@
 #define UTILS_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 // Function prototypes
 void utils_clean_buffer(char *buffer);
 void utils_sleep_ms(int milliseconds);
+int64_t utils_monotonic_ns(void);
 
 #endif // UTILS_H
@@ -19,10 +19,9 @@ fi
 # Check for required dependencies
 echo "Checking for required dependencies..."
 if ! command -v smartctl &> /dev/null; then
-    echo "Error: smartmontools is not installed"
-    echo "Please install it with: sudo apt-get install -y smartmontools"
-    echo "Or install the package with dependencies: sudo apt-get install -f"
-    exit 1
+    echo "Warning: smartmontools is not installed"
+    echo "The daemon will use the native NVME sensor; the smartctl fallback command will not work"
+    echo "Install it with: sudo apt-get install -y smartmontools"
 fi
 
 # Auto-detect serial port
@@ -130,12 +129,11 @@ fi
 
 # Test NVME temperature command
 echo "Testing NVME temperature command..."
-NVME_TEMP_OUTPUT=$(eval $NVME_CMD 2>&1)
-if [ $? -ne 0 ]; then
-    echo "Warning: NVME temperature command failed: $NVME_TEMP_OUTPUT"
-    echo "You may need to manually edit the configuration file after installation."
-else
+if NVME_TEMP_OUTPUT=$(eval $NVME_CMD 2>&1); then
     echo "NVME temperature command test successful: $NVME_TEMP_OUTPUT"
+else
+    echo "Warning: NVME temperature command failed: $NVME_TEMP_OUTPUT"
+    echo "The daemon will rely on the native NVME sensor (FAN_TEMP_NVME_SOURCE=auto)."
 fi
 
 # Set the final command variables
@@ -161,9 +159,15 @@ FAN_TEMP_READ_TIMEOUT=$FAN_TEMP_READ_TIMEOUT
 # Log to syslog (1) or stdout (0)
 FAN_TEMP_LOG_TO_SYSLOG=$FAN_TEMP_LOG_TO_SYSLOG
 
+# CPU temperature source: auto (native sysfs, command as fallback), native, or cmd
+FAN_TEMP_CPU_SOURCE=auto
+
 # Command to get CPU temperature
 FAN_TEMP_CPU_CMD=$FAN_TEMP_CPU_CMD
 
+# NVME temperature source: auto (native hwmon/ioctl, command as fallback), native, or cmd
+FAN_TEMP_NVME_SOURCE=auto
+
 # Command to get NVME temperature
 FAN_TEMP_NVME_CMD=$FAN_TEMP_NVME_CMD
 
@@ -0,0 +1,43 @@
+/**
+ * Baud rate module for Fan Temperature Daemon
+ * Sets arbitrary rates through termios2 and BOTHER. Kept in its own
+ * translation unit because <asm/termbits.h> conflicts with <termios.h>
+ */
+
+#include "baud.h"
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+
+/**
+ * Set input and output speed to any rate the UART clock can approximate
+ * Returns 0 on success, -1 with errno set on failure
+ */
+int baud_set(int fd, int rate) {
+    struct termios2 tio;
+    
+    if (ioctl(fd, TCGETS2, &tio) != 0) {
+        return -1;
+    }
+    
+    tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = (speed_t)rate;
+    tio.c_ospeed = (speed_t)rate;
+    
+    return ioctl(fd, TCSETS2, &tio);
+}
+
+/**
+ * Read back the output speed the driver actually applied
+ * Returns 0 on success, -1 with errno set on failure
+ */
+int baud_get(int fd, int *rate) {
+    struct termios2 tio;
+    
+    if (ioctl(fd, TCGETS2, &tio) != 0) {
+        return -1;
+    }
+    
+    *rate = (int)tio.c_ospeed;
+    return 0;
+}
@@ -0,0 +1,202 @@
+/**
+ * Command runner module for Fan Temperature Daemon
+ * Runs sensor commands with posix_spawn under a hard deadline and
+ * keeps per-command latency statistics
+ */
+
+#define _GNU_SOURCE
+#include "command.h"
+#include "logger.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <poll.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+/**
+ * Spawn "/bin/sh -c cmd" in its own process group with stdout on a pipe
+ * Returns the child pid and the non-blocking read end of the pipe
+ */
+pid_t command_spawn(const char *cmd, int *stdout_fd) {
+    int pipe_fds[2];
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t empty_mask, default_signals;
+    pid_t pid;
+    
+    // Close-on-exec from the start, so a concurrent spawn cannot inherit either end;
+    // only the read end is non-blocking, the child's stdout shares the write end's flags
+    if (pipe2(pipe_fds, O_CLOEXEC) != 0) {
+        return -1;
+    }
+    fcntl(pipe_fds[0], F_SETFL, O_NONBLOCK);
+    
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+    
+    // Own process group so a whole pipeline can be killed; the sampler thread
+    // blocks all signals, so reset the mask and dispositions for the child
+    posix_spawnattr_init(&attr);
+    sigemptyset(&empty_mask);
+    sigfillset(&default_signals);
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setsigmask(&attr, &empty_mask);
+    posix_spawnattr_setsigdefault(&attr, &default_signals);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+    
+    char *argv[] = {"sh", "-c", (char *)cmd, NULL};
+    int result = posix_spawn(&pid, "/bin/sh", &actions, &attr, argv, environ);
+    
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(pipe_fds[1]);
+    
+    if (result != 0) {
+        close(pipe_fds[0]);
+        errno = result;
+        return -1;
+    }
+    
+    *stdout_fd = pipe_fds[0];
+    return pid;
+}
+
+/**
+ * Record one command duration in the statistics window
+ */
+static void record_duration(command_stats_t *stats, int64_t duration_ns) {
+    stats->samples_ns[stats->next_sample] = duration_ns;
+    stats->next_sample = (stats->next_sample + 1) % COMMAND_STATS_WINDOW;
+    if (stats->sample_count < COMMAND_STATS_WINDOW) {
+        stats->sample_count++;
+    }
+    if (duration_ns > stats->max_ns) {
+        stats->max_ns = duration_ns;
+    }
+}
+
+/**
+ * Run a command and collect its output, killing it when the deadline passes
+ * Returns the number of output bytes, or -1 on spawn failure or timeout
+ */
+int command_run(const char *cmd, char *output, size_t size, int deadline_ms, command_stats_t *stats) {
+    int fd;
+    size_t used = 0;
+    int timed_out = 0;
+    int64_t start_ns = utils_monotonic_ns();
+    int64_t deadline_ns = start_ns + (int64_t)deadline_ms * 1000000LL;
+    
+    if (cmd == NULL || output == NULL || size == 0) {
+        return -1;
+    }
+    
+    stats->runs++;
+    
+    pid_t pid = command_spawn(cmd, &fd);
+    if (pid < 0) {
+        LOG_MESSAGE_ERR("Failed to spawn %s command: %s", stats->name, strerror(errno));
+        stats->failures++;
+        return -1;
+    }
+    
+    // Read output until EOF or deadline
+    for (;;) {
+        int64_t remaining_ms = (deadline_ns - utils_monotonic_ns()) / 1000000LL;
+        if (remaining_ms <= 0) {
+            timed_out = 1;
+            break;
+        }
+        
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        int ready = poll(&pfd, 1, (int)remaining_ms);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            timed_out = (ready == 0);
+            break;
+        }
+        
+        char discard[256];
+        char *dest = used < size - 1 ? output + used : discard;
+        size_t room = used < size - 1 ? size - 1 - used : sizeof(discard);
+        ssize_t len = read(fd, dest, room);
+        if (len > 0) {
+            if (dest != discard) {
+                used += (size_t)len;
+            }
+        } else if (len == 0 || (errno != EAGAIN && errno != EINTR)) {
+            break;  // EOF or read error
+        }
+    }
+    close(fd);
+    output[used] = '\0';
+    
+    // Reap the child; a hung command (or one still running after closing stdout) is killed
+    int status = 0;
+    while (!timed_out && waitpid(pid, &status, WNOHANG) == 0) {
+        if (utils_monotonic_ns() >= deadline_ns) {
+            timed_out = 1;
+            break;
+        }
+        utils_sleep_ms(1);
+    }
+    if (timed_out) {
+        kill(-pid, SIGKILL);
+        waitpid(pid, &status, 0);
+    }
+    
+    int64_t duration_ns = utils_monotonic_ns() - start_ns;
+    record_duration(stats, duration_ns);
+    
+    if (timed_out) {
+        stats->timeouts++;
+        LOG_MESSAGE_WARNING("%s command killed after %dms deadline: %s", stats->name, deadline_ms, cmd);
+        return -1;
+    }
+    
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        stats->failures++;
+    }
+    
+    return (int)used;
+}
+
+/**
+ * Compare two durations for qsort
+ */
+static int compare_ns(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Log p50/p99/max latency and timeout counters for a command
+ */
+void command_log_stats(const command_stats_t *stats) {
+    int64_t sorted[COMMAND_STATS_WINDOW];
+    
+    if (stats->sample_count == 0) {
+        return;
+    }
+    
+    memcpy(sorted, stats->samples_ns, stats->sample_count * sizeof(sorted[0]));
+    qsort(sorted, stats->sample_count, sizeof(sorted[0]), compare_ns);
+    
+    int64_t p50 = sorted[(stats->sample_count - 1) * 50 / 100];
+    int64_t p99 = sorted[(stats->sample_count - 1) * 99 / 100];
+    
+    LOG_MESSAGE_INFO("%s command latency: p50 %.1fms p99 %.1fms max %.1fms (runs: %lu, timeouts: %lu, failures: %lu)",
+                     stats->name, p50 / 1e6, p99 / 1e6, stats->max_ns / 1e6,
+                     stats->runs, stats->timeouts, stats->failures);
+}
@@ -4,28 +4,83 @@
  */
 
 #include "config.h"
+#include "trend.h"
+#include "baud.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <termios.h>
 
 // Global configuration instance
 config_t g_config = {0};
 
 /**
- * Parse baud rate string to termios speed_t value
+ * Parse baud rate string to bits per second
+ * Any rate is accepted, it is applied through termios2; returns 0 if invalid
  */
-speed_t config_parse_baud_rate(const char *baud_str) {
-    long baud = atol(baud_str);
+int config_parse_baud_rate(const char *baud_str) {
+    char *end;
+    long baud = strtol(baud_str, &end, 10);
     
-    switch (baud) {
-        case 9600:   return B9600;
-        case 19200:  return B19200;
-        case 38400:  return B38400;
-        case 57600:  return B57600;
-        case 115200: return B115200;
-        default:     return B0;  // Invalid baud rate
+    if (end == baud_str || *end != '\0' || baud < BAUD_MIN || baud > BAUD_MAX) {
+        return 0;  // Invalid baud rate
     }
+    return (int)baud;
+}
+
+/**
+ * Parse temperature source string to temp_source_t value
+ */
+int config_parse_source(const char *source_str) {
+    if (strcmp(source_str, "auto") == 0) {
+        return TEMP_SOURCE_AUTO;
+    } else if (strcmp(source_str, "native") == 0) {
+        return TEMP_SOURCE_NATIVE;
+    } else if (strcmp(source_str, "cmd") == 0) {
+        return TEMP_SOURCE_CMD;
+    } else if (strcmp(source_str, "coproc") == 0) {
+        return TEMP_SOURCE_COPROC;
+    }
+    
+    return -1;  // Invalid source
+}
+
+/**
+ * Parse sensor aggregation string to temp_aggregate_t value
+ */
+int config_parse_aggregate(const char *aggregate_str) {
+    if (strcmp(aggregate_str, "max") == 0) {
+        return TEMP_AGGREGATE_MAX;
+    } else if (strcmp(aggregate_str, "mean") == 0) {
+        return TEMP_AGGREGATE_MEAN;
+    }
+    
+    return -1;  // Invalid aggregation
+}
+
+/**
+ * Check a sensor weight list of the form "label:weight,label:weight"
+ */
+static int validate_sensor_weights(const char *weights) {
+    const char *entry = weights;
+    
+    while (*entry != '\0') {
+        const char *colon = strchr(entry, ':');
+        const char *comma = strchr(entry, ',');
+        char *end;
+        
+        if (colon == NULL || colon == entry || (comma != NULL && comma < colon)) {
+            return -1;
+        }
+        
+        float weight = strtof(colon + 1, &end);
+        if (end == colon + 1 || weight < 0 || (*end != ',' && *end != '\0')) {
+            return -1;
+        }
+        
+        entry = *end == ',' ? end + 1 : end;
+    }
+    
+    return 0;
 }
 
 /**
@@ -54,16 +109,6 @@ static int check_required_env_vars(void) {
         missing = 1;
     }
     
-    if (getenv(ENV_CPU_TEMP_CMD) == NULL) {
-        fprintf(stderr, "Error: %s environment variable is not set\n", ENV_CPU_TEMP_CMD);
-        missing = 1;
-    }
-    
-    if (getenv(ENV_NVME_TEMP_CMD) == NULL) {
-        fprintf(stderr, "Error: %s environment variable is not set\n", ENV_NVME_TEMP_CMD);
-        missing = 1;
-    }
-    
     if (getenv(ENV_FOREGROUND) == NULL) {
         fprintf(stderr, "Error: %s environment variable is not set\n", ENV_FOREGROUND);
         missing = 1;
@@ -99,7 +144,7 @@ int config_load_from_env(void) {
     env_val = getenv(ENV_BAUD_RATE);
     if (env_val != NULL) {
         g_config.baud_rate = config_parse_baud_rate(env_val);
-        if (g_config.baud_rate == B0) {
+        if (g_config.baud_rate == 0) {
             fprintf(stderr, "Error: Invalid baud rate: %s\n", env_val);
             return -1;
         }
@@ -145,6 +190,203 @@ int config_load_from_env(void) {
         g_config.verbose = atoi(env_val);
     }
     
+    // Load CPU temperature source (optional, defaults to auto)
+    g_config.cpu_source = TEMP_SOURCE_AUTO;
+    env_val = getenv(ENV_CPU_SOURCE);
+    if (env_val != NULL) {
+        int source = config_parse_source(env_val);
+        if (source < 0) {
+            fprintf(stderr, "Error: Invalid CPU temperature source: %s\n", env_val);
+            return -1;
+        }
+        g_config.cpu_source = (temp_source_t)source;
+    }
+    
+    // Load CPU sensor path (optional, auto-detected when not set)
+    env_val = getenv(ENV_CPU_SENSOR);
+    if (env_val != NULL) {
+        g_config.cpu_sensor_path = strdup(env_val);
+    }
+    
+    // Load NVME temperature source (optional, defaults to auto)
+    g_config.nvme_source = TEMP_SOURCE_AUTO;
+    env_val = getenv(ENV_NVME_SOURCE);
+    if (env_val != NULL) {
+        int source = config_parse_source(env_val);
+        if (source < 0) {
+            fprintf(stderr, "Error: Invalid NVME temperature source: %s\n", env_val);
+            return -1;
+        }
+        g_config.nvme_source = (temp_source_t)source;
+    }
+    
+    // Load NVME device (optional)
+    env_val = getenv(ENV_NVME_DEVICE);
+    g_config.nvme_device = strdup(env_val != NULL ? env_val : DEFAULT_NVME_DEVICE);
+    
+    // Load sysfs root (optional, allows pointing the daemon at a fake sysfs tree)
+    env_val = getenv(ENV_SYSFS_ROOT);
+    g_config.sysfs_root = strdup(env_val != NULL ? env_val : DEFAULT_SYSFS_ROOT);
+    
+    // Load procfs root (optional, same purpose for the CPU load counters)
+    env_val = getenv(ENV_PROC_ROOT);
+    g_config.proc_root = strdup(env_val != NULL ? env_val : DEFAULT_PROC_ROOT);
+    
+    // Load per-sensor refresh intervals (optional, also the cache TTL)
+    g_config.cpu_interval_ms = DEFAULT_CPU_INTERVAL_MS;
+    env_val = getenv(ENV_CPU_INTERVAL);
+    if (env_val != NULL) {
+        g_config.cpu_interval_ms = atoi(env_val);
+        if (g_config.cpu_interval_ms <= 0) {
+            fprintf(stderr, "Error: Invalid CPU refresh interval: %s\n", env_val);
+            return -1;
+        }
+    }
+    
+    g_config.nvme_interval_ms = DEFAULT_NVME_INTERVAL_MS;
+    env_val = getenv(ENV_NVME_INTERVAL);
+    if (env_val != NULL) {
+        g_config.nvme_interval_ms = atoi(env_val);
+        if (g_config.nvme_interval_ms <= 0) {
+            fprintf(stderr, "Error: Invalid NVME refresh interval: %s\n", env_val);
+            return -1;
+        }
+    }
+    
+    // Load sensor command deadline (optional)
+    g_config.cmd_timeout_ms = DEFAULT_CMD_TIMEOUT_MS;
+    env_val = getenv(ENV_CMD_TIMEOUT);
+    if (env_val != NULL) {
+        g_config.cmd_timeout_ms = atoi(env_val);
+        if (g_config.cmd_timeout_ms <= 0) {
+            fprintf(stderr, "Error: Invalid command timeout: %s\n", env_val);
+            return -1;
+        }
+    }
+    
+    // Load coprocess reading lifetime (optional)
+    g_config.coproc_max_age_ms = DEFAULT_COPROC_MAX_AGE_MS;
+    env_val = getenv(ENV_COPROC_MAX_AGE);
+    if (env_val != NULL) {
+        g_config.coproc_max_age_ms = atoi(env_val);
+        if (g_config.coproc_max_age_ms <= 0) {
+            fprintf(stderr, "Error: Invalid coprocess reading age: %s\n", env_val);
+            return -1;
+        }
+    }
+    
+    // Load sensor group aggregation (optional, defaults to the hottest sensor)
+    g_config.cpu_aggregate = TEMP_AGGREGATE_MAX;
+    env_val = getenv(ENV_CPU_AGGREGATE);
+    if (env_val != NULL) {
+        int aggregate = config_parse_aggregate(env_val);
+        if (aggregate < 0) {
+            fprintf(stderr, "Error: Invalid CPU sensor aggregation: %s\n", env_val);
+            return -1;
+        }
+        g_config.cpu_aggregate = (temp_aggregate_t)aggregate;
+    }
+    
+    g_config.nvme_aggregate = TEMP_AGGREGATE_MAX;
+    env_val = getenv(ENV_NVME_AGGREGATE);
+    if (env_val != NULL) {
+        int aggregate = config_parse_aggregate(env_val);
+        if (aggregate < 0) {
+            fprintf(stderr, "Error: Invalid NVME sensor aggregation: %s\n", env_val);
+            return -1;
+        }
+        g_config.nvme_aggregate = (temp_aggregate_t)aggregate;
+    }
+    
+    // Load serial drain mode (optional, wait for each response to be transmitted)
+    env_val = getenv(ENV_SERIAL_DRAIN);
+    if (env_val != NULL) {
+        g_config.serial_drain = atoi(env_val);
+    }
+    
+    // Load per-sensor weights (optional)
+    env_val = getenv(ENV_SENSOR_WEIGHTS);
+    if (env_val != NULL) {
+        if (validate_sensor_weights(env_val) != 0) {
+            fprintf(stderr, "Error: Invalid sensor weights: %s\n", env_val);
+            return -1;
+        }
+        g_config.sensor_weights = strdup(env_val);
+    }
+    
+    // Load low-latency serial profile (optional)
+    env_val = getenv(ENV_LOW_LATENCY);
+    if (env_val != NULL) {
+        g_config.low_latency = atoi(env_val);
+    }
+    
+    // Load negotiation limit (optional, 0 keeps the configured baud rate)
+    g_config.baud_max = DEFAULT_BAUD_MAX;
+    env_val = getenv(ENV_BAUD_MAX);
+    if (env_val != NULL) {
+        g_config.baud_max = strcmp(env_val, "0") == 0 ? 0 : config_parse_baud_rate(env_val);
+        if (g_config.baud_max == 0 && strcmp(env_val, "0") != 0) {
+            fprintf(stderr, "Error: Invalid maximum baud rate: %s\n", env_val);
+            return -1;
+        }
+    }
+    
+    // Load push mode thresholds (optional, a delta of 0 refuses push mode)
+    g_config.push_delta = DEFAULT_PUSH_DELTA;
+    env_val = getenv(ENV_PUSH_DELTA);
+    if (env_val != NULL) {
+        char *end;
+        g_config.push_delta = strtof(env_val, &end);
+        if (end == env_val || *end != '\0' || !(g_config.push_delta >= 0)) {
+            fprintf(stderr, "Error: Invalid push delta: %s\n", env_val);
+            return -1;
+        }
+    }
+    
+    g_config.push_heartbeat_ms = DEFAULT_PUSH_HEARTBEAT_MS;
+    env_val = getenv(ENV_PUSH_HEARTBEAT);
+    if (env_val != NULL) {
+        g_config.push_heartbeat_ms = atoi(env_val);
+        if (g_config.push_heartbeat_ms < PUSH_HEARTBEAT_MIN_MS || g_config.push_heartbeat_ms > PUSH_HEARTBEAT_MAX_MS) {
+            fprintf(stderr, "Error: Invalid push heartbeat (%d-%dms): %s\n",
+                    PUSH_HEARTBEAT_MIN_MS, PUSH_HEARTBEAT_MAX_MS, env_val);
+            return -1;
+        }
+    }
+    
+    // Load metrics endpoints (optional, both disabled by default)
+    env_val = getenv(ENV_METRICS_SOCKET);
+    if (env_val != NULL && env_val[0] != '\0') {
+        g_config.metrics_socket = strdup(env_val);
+    }
+    
+    env_val = getenv(ENV_METRICS_TEXTFILE);
+    if (env_val != NULL && env_val[0] != '\0') {
+        g_config.metrics_textfile = strdup(env_val);
+    }
+    
+    g_config.metrics_interval_ms = DEFAULT_METRICS_INTERVAL_MS;
+    env_val = getenv(ENV_METRICS_INTERVAL);
+    if (env_val != NULL) {
+        g_config.metrics_interval_ms = atoi(env_val);
+        if (g_config.metrics_interval_ms < METRICS_INTERVAL_MIN_MS || g_config.metrics_interval_ms > METRICS_INTERVAL_MAX_MS) {
+            fprintf(stderr, "Error: Invalid metrics interval (%d-%dms): %s\n",
+                    METRICS_INTERVAL_MIN_MS, METRICS_INTERVAL_MAX_MS, env_val);
+            return -1;
+        }
+    }
+    
+    // Load trend window (optional, 0 disables the trend fields)
+    g_config.trend_samples = DEFAULT_TREND_SAMPLES;
+    env_val = getenv(ENV_TREND_SAMPLES);
+    if (env_val != NULL) {
+        g_config.trend_samples = atoi(env_val);
+        if (g_config.trend_samples == 1 || g_config.trend_samples < 0 || g_config.trend_samples > TREND_MAX_SAMPLES) {
+            fprintf(stderr, "Error: Invalid trend sample count (0 or 2-%d): %s\n", TREND_MAX_SAMPLES, env_val);
+            return -1;
+        }
+    }
+    
     return 0;
 }
 
@@ -157,7 +399,7 @@ int config_validate(void) {
         return -1;
     }
     
-    if (g_config.baud_rate == B0) {
+    if (g_config.baud_rate == 0) {
         fprintf(stderr, "Error: Invalid baud rate\n");
         return -1;
     }
@@ -167,12 +409,14 @@ int config_validate(void) {
         return -1;
     }
     
-    if (g_config.cpu_temp_cmd == NULL || strlen(g_config.cpu_temp_cmd) == 0) {
+    if ((g_config.cpu_source == TEMP_SOURCE_CMD || g_config.cpu_source == TEMP_SOURCE_COPROC) &&
+        (g_config.cpu_temp_cmd == NULL || strlen(g_config.cpu_temp_cmd) == 0)) {
         fprintf(stderr, "Error: CPU temperature command not configured\n");
         return -1;
     }
     
-    if (g_config.nvme_temp_cmd == NULL || strlen(g_config.nvme_temp_cmd) == 0) {
+    if ((g_config.nvme_source == TEMP_SOURCE_CMD || g_config.nvme_source == TEMP_SOURCE_COPROC) &&
+        (g_config.nvme_temp_cmd == NULL || strlen(g_config.nvme_temp_cmd) == 0)) {
         fprintf(stderr, "Error: NVME temperature command not configured\n");
         return -1;
     }
@@ -190,10 +434,33 @@ void config_print_usage(void) {
     fprintf(stderr, "  export %s=115200\n", ENV_BAUD_RATE);
     fprintf(stderr, "  export %s=1\n", ENV_READ_TIMEOUT);
     fprintf(stderr, "  export %s=1\n", ENV_LOG_TO_SYSLOG);
-    fprintf(stderr, "  export %s=\"/usr/bin/vcgencmd measure_temp\"\n", ENV_CPU_TEMP_CMD);
-    fprintf(stderr, "  export %s=\"smartctl -A /dev/nvme0 | grep Temperature\"\n", ENV_NVME_TEMP_CMD);
     fprintf(stderr, "  export %s=0\n", ENV_FOREGROUND);
     fprintf(stderr, "  export %s=0\n", ENV_VERBOSE);
+    fprintf(stderr, "\nOptional environment variables:\n");
+    fprintf(stderr, "  %s=auto|native|cmd|coproc (default: auto)\n", ENV_CPU_SOURCE);
+    fprintf(stderr, "  %s=/sys/class/thermal/thermal_zone0/temp[,...] (default: auto-detected)\n", ENV_CPU_SENSOR);
+    fprintf(stderr, "  %s=max|mean (default: max)\n", ENV_CPU_AGGREGATE);
+    fprintf(stderr, "  %s=\"/usr/bin/vcgencmd measure_temp\" (fallback for auto, required for cmd/coproc)\n", ENV_CPU_TEMP_CMD);
+    fprintf(stderr, "  %s=auto|native|cmd|coproc (default: auto)\n", ENV_NVME_SOURCE);
+    fprintf(stderr, "  %s=max|mean (default: max)\n", ENV_NVME_AGGREGATE);
+    fprintf(stderr, "  %s=cpu-thermal:2,nvme1:0.5 (default: all sensors weight 1)\n", ENV_SENSOR_WEIGHTS);
+    fprintf(stderr, "  %s=%s (default)\n", ENV_NVME_DEVICE, DEFAULT_NVME_DEVICE);
+    fprintf(stderr, "  %s=\"smartctl -A /dev/nvme0 | grep Temperature\" (fallback for auto, required for cmd/coproc)\n", ENV_NVME_TEMP_CMD);
+    fprintf(stderr, "  %s=%s (default)\n", ENV_SYSFS_ROOT, DEFAULT_SYSFS_ROOT);
+    fprintf(stderr, "  %s=%s (default)\n", ENV_PROC_ROOT, DEFAULT_PROC_ROOT);
+    fprintf(stderr, "  %s=%d (default)\n", ENV_CPU_INTERVAL, DEFAULT_CPU_INTERVAL_MS);
+    fprintf(stderr, "  %s=%d (default)\n", ENV_NVME_INTERVAL, DEFAULT_NVME_INTERVAL_MS);
+    fprintf(stderr, "  %s=%d (default)\n", ENV_CMD_TIMEOUT, DEFAULT_CMD_TIMEOUT_MS);
+    fprintf(stderr, "  %s=%d (default)\n", ENV_COPROC_MAX_AGE, DEFAULT_COPROC_MAX_AGE_MS);
+    fprintf(stderr, "  %s=%d (default, 0 disables trend reporting)\n", ENV_TREND_SAMPLES, DEFAULT_TREND_SAMPLES);
+    fprintf(stderr, "  %s=0 (default, 1 waits until each response is transmitted)\n", ENV_SERIAL_DRAIN);
+    fprintf(stderr, "  %s=%d (default, 0 disables baud rate negotiation)\n", ENV_BAUD_MAX, DEFAULT_BAUD_MAX);
+    fprintf(stderr, "  %s=0 (default, 1 enables the low-latency serial profile)\n", ENV_LOW_LATENCY);
+    fprintf(stderr, "  %s=%.1f (default, 0 refuses push mode)\n", ENV_PUSH_DELTA, DEFAULT_PUSH_DELTA);
+    fprintf(stderr, "  %s=%d (default)\n", ENV_PUSH_HEARTBEAT, DEFAULT_PUSH_HEARTBEAT_MS);
+    fprintf(stderr, "  %s=/run/fan-temp-daemon/metrics.sock (default: no socket)\n", ENV_METRICS_SOCKET);
+    fprintf(stderr, "  %s=/var/lib/node_exporter/textfile_collector/fan_temp_daemon.prom (default: no textfile)\n", ENV_METRICS_TEXTFILE);
+    fprintf(stderr, "  %s=%d (default)\n", ENV_METRICS_INTERVAL, DEFAULT_METRICS_INTERVAL_MS);
 }
 
 /**
@@ -214,4 +481,39 @@ void config_cleanup(void) {
         free(g_config.nvme_temp_cmd);
         g_config.nvme_temp_cmd = NULL;
     }
+    
+    if (g_config.cpu_sensor_path) {
+        free(g_config.cpu_sensor_path);
+        g_config.cpu_sensor_path = NULL;
+    }
+    
+    if (g_config.nvme_device) {
+        free(g_config.nvme_device);
+        g_config.nvme_device = NULL;
+    }
+    
+    if (g_config.sysfs_root) {
+        free(g_config.sysfs_root);
+        g_config.sysfs_root = NULL;
+    }
+    
+    if (g_config.proc_root) {
+        free(g_config.proc_root);
+        g_config.proc_root = NULL;
+    }
+    
+    if (g_config.metrics_socket) {
+        free(g_config.metrics_socket);
+        g_config.metrics_socket = NULL;
+    }
+    
+    if (g_config.metrics_textfile) {
+        free(g_config.metrics_textfile);
+        g_config.metrics_textfile = NULL;
+    }
+    
+    if (g_config.sensor_weights) {
+        free(g_config.sensor_weights);
+        g_config.sensor_weights = NULL;
+    }
 }
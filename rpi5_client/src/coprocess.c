@@ -0,0 +1,181 @@
+/**
+ * Coprocess module for Fan Temperature Daemon
+ * Runs a custom sensor command once as a persistent child and reads
+ * its readings line by line without blocking
+ */
+
+#include "coprocess.h"
+#include "command.h"
+#include "logger.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#define COPROC_MIN_BACKOFF_MS   500
+#define COPROC_MAX_BACKOFF_MS   60000
+#define COPROC_STABLE_RUN_NS    (10LL * 1000000000LL)  // Runs longer than this reset the backoff
+
+/**
+ * Spawn the command with its stdout connected to a non-blocking pipe
+ */
+static int spawn_child(coprocess_t *cp) {
+    int fd;
+    
+    pid_t pid = command_spawn(cp->cmd, &fd);
+    if (pid < 0) {
+        LOG_MESSAGE_ERR("Failed to start %s coprocess: %s", cp->name, strerror(errno));
+        return -1;
+    }
+    
+    cp->pid = pid;
+    cp->fd = fd;
+    cp->line_len = 0;
+    cp->started_ns = utils_monotonic_ns();
+    
+    LOG_MESSAGE_INFO("%s coprocess started (pid %d): %s", cp->name, (int)pid, cp->cmd);
+    return 0;
+}
+
+/**
+ * Reap the child and schedule a restart with exponential backoff on repeated crashes
+ */
+static void handle_child_exit(coprocess_t *cp) {
+    int status = 0;
+    int64_t now_ns = utils_monotonic_ns();
+    
+    if (cp->fd >= 0) {
+        close(cp->fd);
+        cp->fd = -1;
+    }
+    
+    if (cp->pid > 0) {
+        kill(-cp->pid, SIGKILL);  // Stop any remaining pipeline members
+        waitpid(cp->pid, &status, 0);
+    }
+    
+    if (now_ns - cp->started_ns >= COPROC_STABLE_RUN_NS) {
+        cp->backoff_ms = COPROC_MIN_BACKOFF_MS;
+    } else if (cp->backoff_ms < COPROC_MAX_BACKOFF_MS) {
+        cp->backoff_ms = cp->backoff_ms ? cp->backoff_ms * 2 : COPROC_MIN_BACKOFF_MS;
+        if (cp->backoff_ms > COPROC_MAX_BACKOFF_MS) {
+            cp->backoff_ms = COPROC_MAX_BACKOFF_MS;
+        }
+    }
+    
+    LOG_MESSAGE_WARNING("%s coprocess (pid %d) exited with status %d, restarting in %dms",
+                        cp->name, (int)cp->pid,
+                        WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status),
+                        cp->backoff_ms);
+    
+    cp->pid = -1;
+    cp->restart_at_ns = now_ns + (int64_t)cp->backoff_ms * 1000000LL;
+}
+
+/**
+ * Parse every complete line in the accumulator, keeping the latest valid reading
+ */
+static void consume_lines(coprocess_t *cp, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == '\n') {
+            float value;
+            cp->line[cp->line_len] = '\0';
+            if (cp->line_len > 0 && cp->parse(cp->line, &value) == 0) {
+                cp->value = value;
+                cp->has_value = 1;
+                cp->value_ns = utils_monotonic_ns();
+            }
+            cp->line_len = 0;
+        } else if (cp->line_len < sizeof(cp->line) - 1) {
+            cp->line[cp->line_len++] = data[i];
+        }
+    }
+}
+
+/**
+ * Start the coprocess, readings older than max_age_ms are dropped
+ */
+int coprocess_start(coprocess_t *cp, const char *name, const char *cmd, coprocess_parse_fn parse, int max_age_ms) {
+    memset(cp, 0, sizeof(*cp));
+    cp->name = name;
+    cp->cmd = cmd;
+    cp->parse = parse;
+    cp->max_age_ms = max_age_ms;
+    cp->pid = -1;
+    cp->fd = -1;
+    
+    return spawn_child(cp);
+}
+
+/**
+ * Drain pending output without blocking and restart the child if it is due
+ * Returns 0 when a reading newer than the maximum age is available in value
+ */
+int coprocess_poll(coprocess_t *cp, float *value) {
+    char buf[256];
+    
+    if (cp->fd < 0 && cp->pid < 0 && utils_monotonic_ns() >= cp->restart_at_ns) {
+        cp->restarts++;
+        if (spawn_child(cp) != 0) {
+            cp->started_ns = utils_monotonic_ns();
+            handle_child_exit(cp);
+        }
+    }
+    
+    while (cp->fd >= 0) {
+        ssize_t len = read(cp->fd, buf, sizeof(buf));
+        if (len > 0) {
+            consume_lines(cp, buf, (size_t)len);
+        } else if (len == 0) {
+            handle_child_exit(cp);  // EOF: the child exited or closed stdout
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                handle_child_exit(cp);
+            }
+            break;
+        }
+    }
+    
+    // A dead, crash-looping or silent child must not keep reporting its last line
+    if (cp->has_value && utils_monotonic_ns() - cp->value_ns > (int64_t)cp->max_age_ms * 1000000LL) {
+        LOG_MESSAGE_WARNING("%s coprocess has not written a reading for %dms", cp->name, cp->max_age_ms);
+        cp->has_value = 0;
+    }
+    
+    if (!cp->has_value) {
+        return -1;
+    }
+    
+    *value = cp->value;
+    return 0;
+}
+
+/**
+ * Stop the coprocess and reap it
+ */
+void coprocess_stop(coprocess_t *cp) {
+    if (cp->fd >= 0) {
+        close(cp->fd);
+        cp->fd = -1;
+    }
+    
+    if (cp->pid > 0) {
+        kill(-cp->pid, SIGTERM);
+        
+        // Give the child a moment to exit cleanly before forcing it
+        for (int i = 0; i < 20 && waitpid(cp->pid, NULL, WNOHANG) == 0; i++) {
+            utils_sleep_ms(10);
+        }
+        if (kill(cp->pid, 0) == 0) {
+            kill(-cp->pid, SIGKILL);
+            waitpid(cp->pid, NULL, 0);
+        }
+        cp->pid = -1;
+    }
+}
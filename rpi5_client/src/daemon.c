@@ -16,7 +16,7 @@
 volatile int g_running = 1;
 
 /**
- * Signal handler
+ * Signal handler, called from the event loop when a signal arrives on the signalfd
  */
 void daemon_signal_handler(int sig) {
     switch (sig) {
@@ -36,12 +36,16 @@ void daemon_signal_handler(int sig) {
 }
 
 /**
- * Setup signal handlers
+ * Block the handled signals so they are only delivered through a signalfd
+ * Must run before any thread is created so every thread inherits the mask
  */
-void daemon_setup_signals(void) {
-    signal(SIGINT, daemon_signal_handler);
-    signal(SIGTERM, daemon_signal_handler);
-    signal(SIGHUP, daemon_signal_handler);
+void daemon_setup_signals(sigset_t *signals) {
+    sigemptyset(signals);
+    sigaddset(signals, SIGINT);
+    sigaddset(signals, SIGTERM);
+    sigaddset(signals, SIGHUP);
+    sigaddset(signals, SIGUSR1);
+    sigprocmask(SIG_BLOCK, signals, NULL);
 }
 
 /**
@@ -0,0 +1,262 @@
+/**
+ * Event loop module for Fan Temperature Daemon
+ * Multiplexes the serial port, timers, signals and other descriptors
+ * with epoll so that no single source can block the others
+ */
+
+#include "event_loop.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+
+// Registered descriptor with its handler
+typedef struct {
+    int fd;
+    int owned;              // Timer and signal fds are created and closed by the loop
+    event_handler_fn handler;
+    void *data;
+    uint32_t generation;    // Bumped on each registration, so events for a previous one are dropped
+} event_source_t;
+
+static int g_epoll_fd = -1;
+static event_source_t g_sources[EVENT_LOOP_MAX_SOURCES];
+static volatile int g_loop_running = 0;
+
+/**
+ * epoll data for a source: slot index in the low half, registration generation in the high half
+ */
+static uint64_t source_key(const event_source_t *source) {
+    return ((uint64_t)source->generation << 32) | (uint64_t)(source - g_sources);
+}
+
+/**
+ * Find the registration of fd
+ */
+static event_source_t *find_source(int fd) {
+    for (int i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        if (g_sources[i].handler != NULL && g_sources[i].fd == fd) {
+            return &g_sources[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Register fd in a free slot and with epoll
+ */
+static int add_source(int fd, uint32_t events, event_handler_fn handler, void *data, int owned) {
+    event_source_t *source = NULL;
+    
+    for (int i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        if (g_sources[i].handler == NULL) {
+            source = &g_sources[i];
+            break;
+        }
+    }
+    
+    if (source == NULL) {
+        LOG_MESSAGE_ERR("Event loop is full, cannot add fd %d", fd);
+        return -1;
+    }
+    
+    source->generation++;
+    struct epoll_event event = {.events = events, .data.u64 = source_key(source)};
+    if (epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        LOG_MESSAGE_ERR("Failed to add fd %d to event loop: %s", fd, strerror(errno));
+        return -1;
+    }
+    
+    source->fd = fd;
+    source->owned = owned;
+    source->handler = handler;
+    source->data = data;
+    return 0;
+}
+
+/**
+ * Create the epoll instance
+ */
+int event_loop_init(void) {
+    memset(g_sources, 0, sizeof(g_sources));
+    
+    g_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (g_epoll_fd < 0) {
+        LOG_MESSAGE_ERR("Failed to create event loop: %s", strerror(errno));
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * Close the epoll instance and all timer and signal fds
+ */
+void event_loop_cleanup(void) {
+    for (int i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        if (g_sources[i].handler != NULL && g_sources[i].owned) {
+            close(g_sources[i].fd);
+        }
+        g_sources[i].handler = NULL;
+    }
+    
+    if (g_epoll_fd >= 0) {
+        close(g_epoll_fd);
+        g_epoll_fd = -1;
+    }
+}
+
+/**
+ * Watch fd for events; the caller keeps ownership of fd
+ */
+int event_loop_add(int fd, uint32_t events, event_handler_fn handler, void *data) {
+    return add_source(fd, events, handler, data, 0);
+}
+
+/**
+ * Change the events watched for fd
+ */
+int event_loop_modify(int fd, uint32_t events) {
+    event_source_t *source = find_source(fd);
+    if (source == NULL) {
+        return -1;
+    }
+    
+    struct epoll_event event = {.events = events, .data.u64 = source_key(source)};
+    return epoll_ctl(g_epoll_fd, EPOLL_CTL_MOD, fd, &event);
+}
+
+/**
+ * Stop watching fd (call before closing it)
+ */
+void event_loop_remove(int fd) {
+    event_source_t *source = find_source(fd);
+    if (source == NULL) {
+        return;
+    }
+    
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    if (source->owned) {
+        close(fd);
+    }
+    source->handler = NULL;
+}
+
+/**
+ * Create a disarmed timer; arm it with event_loop_arm_timer()
+ * Returns the timer fd, the handler must consume it with event_loop_read_timer()
+ */
+int event_loop_add_timer(event_handler_fn handler, void *data) {
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0) {
+        LOG_MESSAGE_ERR("Failed to create timer: %s", strerror(errno));
+        return -1;
+    }
+    
+    if (add_source(timer_fd, EPOLLIN, handler, data, 1) != 0) {
+        close(timer_fd);
+        return -1;
+    }
+    
+    return timer_fd;
+}
+
+/**
+ * Arm a timer to fire after delay_ms, then every interval_ms (0: once)
+ * A delay of 0 disarms the timer
+ */
+int event_loop_arm_timer(int timer_fd, int delay_ms, int interval_ms) {
+    struct itimerspec spec;
+    
+    spec.it_value.tv_sec = delay_ms / 1000;
+    spec.it_value.tv_nsec = (long)(delay_ms % 1000) * 1000000L;
+    spec.it_interval.tv_sec = interval_ms / 1000;
+    spec.it_interval.tv_nsec = (long)(interval_ms % 1000) * 1000000L;
+    
+    return timerfd_settime(timer_fd, 0, &spec, NULL);
+}
+
+/**
+ * Consume a timer event
+ * Returns the number of expirations since the last read
+ */
+uint64_t event_loop_read_timer(int timer_fd) {
+    uint64_t expirations = 0;
+    
+    if (read(timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return 0;
+    }
+    return expirations;
+}
+
+/**
+ * Deliver signals through the loop instead of asynchronous handlers
+ * The signals must already be blocked in every thread
+ */
+int event_loop_add_signals(const sigset_t *signals, event_handler_fn handler, void *data) {
+    int signal_fd = signalfd(-1, signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd < 0) {
+        LOG_MESSAGE_ERR("Failed to create signalfd: %s", strerror(errno));
+        return -1;
+    }
+    
+    if (add_source(signal_fd, EPOLLIN, handler, data, 1) != 0) {
+        close(signal_fd);
+        return -1;
+    }
+    
+    return signal_fd;
+}
+
+/**
+ * Consume one pending signal
+ * Returns the signal number, or 0 when none is pending
+ */
+int event_loop_read_signal(int signal_fd) {
+    struct signalfd_siginfo info;
+    
+    if (read(signal_fd, &info, sizeof(info)) != sizeof(info)) {
+        return 0;
+    }
+    return (int)info.ssi_signo;
+}
+
+/**
+ * Dispatch events until event_loop_stop() is called
+ */
+void event_loop_run(void) {
+    struct epoll_event events[EVENT_LOOP_MAX_SOURCES];
+    
+    g_loop_running = 1;
+    while (g_loop_running) {
+        int count = epoll_wait(g_epoll_fd, events, EVENT_LOOP_MAX_SOURCES, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_MESSAGE_ERR("Event loop wait failed: %s", strerror(errno));
+            break;
+        }
+        
+        for (int i = 0; i < count && g_loop_running; i++) {
+            event_source_t *source = &g_sources[(uint32_t)events[i].data.u64];
+            
+            // A handler earlier in this batch may have removed the source, or removed it
+            // and registered another fd (a reopened port) in the same slot
+            if (source->handler != NULL && source->generation == (uint32_t)(events[i].data.u64 >> 32)) {
+                source->handler(source->fd, events[i].events, source->data);
+            }
+        }
+    }
+}
+
+/**
+ * Make event_loop_run() return after the current event
+ */
+void event_loop_stop(void) {
+    g_loop_running = 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * Line framer module for Fan Temperature Daemon
+ * Splits the serial byte stream into commands using a circular buffer,
+ * so neither buffering nor line extraction moves the buffered bytes
+ */
+
+#include "framer.h"
+#include <string.h>
+
+/**
+ * Byte at logical position pos (0 is the oldest buffered byte)
+ */
+static char byte_at(const framer_t *framer, size_t pos) {
+    return framer->data[(framer->head + pos) % FRAMER_CAPACITY];
+}
+
+/**
+ * Drop count bytes from the front of the buffer
+ */
+static void consume(framer_t *framer, size_t count) {
+    framer->head = (framer->head + count) % FRAMER_CAPACITY;
+    framer->len -= count;
+    framer->scanned = framer->scanned > count ? framer->scanned - count : 0;
+}
+
+/**
+ * Find the first '\n' at or after logical position from
+ * Returns its logical position, or -1 if there is none
+ */
+static long find_newline(const framer_t *framer, size_t from) {
+    size_t start = (framer->head + from) % FRAMER_CAPACITY;
+    size_t remaining = framer->len - from;
+    
+    // The buffered bytes are at most two contiguous runs: up to the end of the array, then from its start
+    size_t first_run = FRAMER_CAPACITY - start < remaining ? FRAMER_CAPACITY - start : remaining;
+    const char *found = memchr(framer->data + start, '\n', first_run);
+    if (found != NULL) {
+        return (long)(from + (size_t)(found - (framer->data + start)));
+    }
+    
+    found = memchr(framer->data, '\n', remaining - first_run);
+    if (found != NULL) {
+        return (long)(from + first_run + (size_t)(found - framer->data));
+    }
+    
+    return -1;
+}
+
+/**
+ * Initialize an empty framer
+ */
+void framer_init(framer_t *framer) {
+    memset(framer, 0, sizeof(*framer));
+}
+
+/**
+ * Append received bytes; when the buffer is full the oldest bytes are dropped
+ */
+void framer_push(framer_t *framer, const char *data, size_t len) {
+    // Only the newest FRAMER_CAPACITY bytes can ever be buffered
+    if (len > FRAMER_CAPACITY) {
+        framer->overflow_bytes += len - FRAMER_CAPACITY;
+        data += len - FRAMER_CAPACITY;
+        len = FRAMER_CAPACITY;
+    }
+    
+    size_t free_space = FRAMER_CAPACITY - framer->len;
+    if (len > free_space) {
+        framer->overflow_bytes += len - free_space;
+        consume(framer, len - free_space);
+    }
+    
+    size_t tail = (framer->head + framer->len) % FRAMER_CAPACITY;
+    size_t first_run = FRAMER_CAPACITY - tail < len ? FRAMER_CAPACITY - tail : len;
+    memcpy(framer->data + tail, data, first_run);
+    memcpy(framer->data, data + first_run, len - first_run);
+    framer->len += len;
+}
+
+/**
+ * Extract the next complete line, without its "\r\n" or "\n" terminator
+ * Empty lines and lines that do not fit into size are skipped
+ * Returns the line length, or 0 if no complete line is buffered
+ */
+int framer_next_line(framer_t *framer, char *line, size_t size) {
+    if (line == NULL || size == 0) {
+        return 0;
+    }
+    
+    for (;;) {
+        long end = find_newline(framer, framer->scanned);
+        if (end < 0) {
+            framer->scanned = framer->len;  // Resume the search here after the next push
+            return 0;
+        }
+        
+        // Trim the '\r' of "\r\n" and any stray carriage returns at the start
+        size_t start = 0;
+        size_t stop = (size_t)end;
+        while (start < stop && byte_at(framer, start) == '\r') {
+            start++;
+        }
+        while (stop > start && byte_at(framer, stop - 1) == '\r') {
+            stop--;
+        }
+        
+        size_t line_len = stop - start;
+        if (line_len > 0 && line_len < size) {
+            for (size_t i = 0; i < line_len; i++) {
+                line[i] = byte_at(framer, start + i);
+            }
+            line[line_len] = '\0';
+            consume(framer, (size_t)end + 1);
+            return (int)line_len;
+        }
+        
+        if (line_len > 0) {
+            framer->skipped_lines++;
+        }
+        consume(framer, (size_t)end + 1);
+    }
+}
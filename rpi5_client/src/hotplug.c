@@ -0,0 +1,172 @@
+/**
+ * Hotplug module for Fan Temperature Daemon
+ * Watches the serial device path with inotify, so that a removed USB serial
+ * adapter is noticed at once and the port is reopened as soon as it returns.
+ * Every directory along the path is watched, since udev removes directories
+ * such as /dev/serial/by-id together with the last device in them
+ */
+
+#include "hotplug.h"
+#include "logger.h"
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#define WATCH_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF)
+
+// One directory along the device path and the entry in it that leads to the device
+typedef struct {
+    char dir[PATH_MAX];
+    char name[NAME_MAX + 1];
+    int wd;
+} watch_t;
+
+static char g_path[PATH_MAX];
+static watch_t g_watches[HOTPLUG_MAX_DEPTH];
+static int g_watch_count = 0;
+static int g_inotify_fd = -1;
+
+/**
+ * Watch every directory of the path that exists now; adding an existing watch is harmless
+ */
+static void add_watches(void) {
+    for (int i = 0; i < g_watch_count; i++) {
+        if (g_watches[i].wd < 0) {
+            g_watches[i].wd = inotify_add_watch(g_inotify_fd, g_watches[i].dir, WATCH_EVENTS | IN_ONLYDIR);
+        }
+    }
+}
+
+/**
+ * Start watching an absolute device path
+ * Returns the inotify fd to poll, or -1 if the path cannot be watched
+ */
+int hotplug_init(const char *path) {
+    if (path == NULL || path[0] != '/' || strlen(path) >= sizeof(g_path)) {
+        LOG_MESSAGE_WARNING("Serial hotplug detection needs an absolute device path");
+        return -1;
+    }
+    
+    snprintf(g_path, sizeof(g_path), "%s", path);
+    g_watch_count = 0;
+    
+    // "/dev/serial/by-id/usb-x": "/" leads on with "dev", "/dev" with "serial", ...
+    for (const char *slash = g_path; slash != NULL; slash = strchr(slash + 1, '/')) {
+        const char *name = slash + 1;
+        const char *end = strchr(name, '/');
+        size_t name_len = end != NULL ? (size_t)(end - name) : strlen(name);
+        size_t dir_len = slash == g_path ? 1 : (size_t)(slash - g_path);
+        
+        if (name_len == 0) {
+            continue;  // Repeated or trailing slash
+        }
+        if (g_watch_count == HOTPLUG_MAX_DEPTH || name_len >= sizeof(g_watches[0].name)) {
+            LOG_MESSAGE_WARNING("Serial device path %s cannot be watched", path);
+            return -1;
+        }
+        
+        watch_t *watch = &g_watches[g_watch_count++];
+        memcpy(watch->dir, g_path, dir_len);
+        watch->dir[dir_len] = '\0';
+        memcpy(watch->name, name, name_len);
+        watch->name[name_len] = '\0';
+        watch->wd = -1;
+    }
+    
+    g_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (g_inotify_fd < 0) {
+        LOG_MESSAGE_WARNING("Serial hotplug detection unavailable: %s", strerror(errno));
+        return -1;
+    }
+    
+    add_watches();
+    LOG_MESSAGE_INFO("Watching %s for hotplug events", g_path);
+    return g_inotify_fd;
+}
+
+/**
+ * Consume pending inotify events
+ * Returns a mask of HOTPLUG_* flags for events that concern the device path
+ */
+int hotplug_read(int fd) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int changes = 0;
+    
+    for (;;) {
+        ssize_t len = read(fd, buffer, sizeof(buffer));
+        if (len <= 0) {
+            break;
+        }
+        
+        for (char *pos = buffer; pos < buffer + len; ) {
+            const struct inotify_event *event = (const struct inotify_event *)pos;
+            pos += sizeof(struct inotify_event) + event->len;
+            
+            for (int i = 0; i < g_watch_count; i++) {
+                watch_t *watch = &g_watches[i];
+                if (watch->wd != event->wd) {
+                    continue;
+                }
+                
+                if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                    // The directory itself went away; its parent reports the removal
+                    if (event->mask & IN_IGNORED) {
+                        watch->wd = -1;
+                    }
+                    break;
+                }
+                
+                if (event->len == 0 || strcmp(event->name, watch->name) != 0) {
+                    break;
+                }
+                
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    changes |= HOTPLUG_CREATED;
+                }
+                if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    changes |= HOTPLUG_REMOVED;
+                }
+                if (event->mask & IN_ATTRIB) {
+                    changes |= HOTPLUG_CHANGED;
+                }
+                
+                if (g_config.verbose) {
+                    LOG_MESSAGE_DEBUG("Hotplug event 0x%x for %s/%s", event->mask,
+                                      strcmp(watch->dir, "/") == 0 ? "" : watch->dir, event->name);
+                }
+                break;
+            }
+        }
+    }
+    
+    // Directories created along the path need their own watches
+    if (changes & HOTPLUG_CREATED) {
+        add_watches();
+    }
+    
+    return changes;
+}
+
+/**
+ * Check if the device path currently resolves to an existing node
+ */
+int hotplug_device_present(void) {
+    struct stat st;
+    return stat(g_path, &st) == 0;
+}
+
+/**
+ * Stop watching
+ */
+void hotplug_cleanup(void) {
+    if (g_inotify_fd >= 0) {
+        close(g_inotify_fd);
+        g_inotify_fd = -1;
+    }
+    g_watch_count = 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * Latency module for Fan Temperature Daemon
+ * Timestamps every POLL at each stage of its handling and keeps a histogram per stage,
+ * so a slow response can be traced to parsing, sampling, formatting or the write
+ */
+
+#include "latency.h"
+#include "logger.h"
+#include "config.h"
+#include "utils.h"
+
+#define SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+
+// Stage names, from each point to the next
+static const char *const g_stage_names[LATENCY_POINTS - 1] = {
+    "Received to parsed", "Parsed to sampled", "Sampled to formatted", "Formatted to written"
+};
+
+static latency_histogram_t g_stages[LATENCY_POINTS - 1];
+static latency_histogram_t g_total;     // Received to written
+static int64_t g_marks_ns[LATENCY_POINTS];
+
+/**
+ * Bucket of a value: exact below 2 * SUB_BUCKETS, then SUB_BUCKETS per power of two
+ */
+static int bucket_index(int64_t value_ns) {
+    uint64_t value = value_ns < 0 ? 0 : (uint64_t)value_ns;
+    
+    if (value >= (UINT64_C(1) << LATENCY_MAX_BITS)) {
+        value = (UINT64_C(1) << LATENCY_MAX_BITS) - 1;
+    }
+    if (value < 2 * SUB_BUCKETS) {
+        return (int)value;
+    }
+    
+    int shift = 63 - __builtin_clzll(value) - LATENCY_SUB_BITS;
+    return ((shift + 1) << LATENCY_SUB_BITS) + (int)(value >> shift) - SUB_BUCKETS;
+}
+
+/**
+ * Highest value that falls into a bucket
+ */
+static int64_t bucket_high(int index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    
+    int shift = (index >> LATENCY_SUB_BITS) - 1;
+    int64_t mantissa = SUB_BUCKETS + (index & (SUB_BUCKETS - 1));
+    return ((mantissa + 1) << shift) - 1;
+}
+
+/**
+ * Add one duration to a histogram
+ */
+void latency_record(latency_histogram_t *histogram, int64_t value_ns) {
+    histogram->counts[bucket_index(value_ns)]++;
+    histogram->total++;
+    if (value_ns > histogram->max_ns) {
+        histogram->max_ns = value_ns;
+    }
+}
+
+/**
+ * Value below which the given percentage of durations fall, within the bucket precision
+ */
+int64_t latency_percentile(const latency_histogram_t *histogram, double percentile) {
+    uint64_t target = (uint64_t)(histogram->total * percentile / 100.0 + 0.5);
+    uint64_t seen = 0;
+    
+    if (target == 0) {
+        target = 1;
+    }
+    
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen == histogram->total) {
+            return histogram->max_ns;
+        }
+        if (seen >= target) {
+            int64_t high = bucket_high(i);
+            return high < histogram->max_ns ? high : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+/**
+ * Timestamp a point in the handling of the current command
+ */
+void latency_mark(latency_point_t point) {
+    g_marks_ns[point] = utils_monotonic_ns();
+}
+
+/**
+ * The response has been written: record every stage of this exchange
+ */
+void latency_complete(void) {
+    g_marks_ns[LATENCY_WRITTEN] = utils_monotonic_ns();
+    
+    // A stage is only recorded when both of its points belong to this exchange
+    for (int point = LATENCY_PARSED; point < LATENCY_POINTS; point++) {
+        if (g_marks_ns[point - 1] != 0 && g_marks_ns[point] >= g_marks_ns[point - 1]) {
+            latency_record(&g_stages[point - 1], g_marks_ns[point] - g_marks_ns[point - 1]);
+        }
+    }
+    if (g_marks_ns[LATENCY_RECEIVED] != 0) {
+        latency_record(&g_total, g_marks_ns[LATENCY_WRITTEN] - g_marks_ns[LATENCY_RECEIVED]);
+    }
+    
+    // Another command in the same read keeps its receive time
+    for (int point = LATENCY_PARSED; point < LATENCY_POINTS; point++) {
+        g_marks_ns[point] = 0;
+    }
+}
+
+/**
+ * Log one histogram
+ */
+static void log_histogram(const char *name, const latency_histogram_t *histogram) {
+    LOG_MESSAGE_INFO("%s latency: p50 %.1fus p99 %.1fus p999 %.1fus max %.1fus (count: %llu)", name,
+                     latency_percentile(histogram, 50.0) / 1e3,
+                     latency_percentile(histogram, 99.0) / 1e3,
+                     latency_percentile(histogram, 99.9) / 1e3,
+                     histogram->max_ns / 1e3, (unsigned long long)histogram->total);
+}
+
+/**
+ * Log p50/p99/p999/max of the whole response and of each stage
+ */
+void latency_log_stats(void) {
+    int drained = g_config.serial_drain;
+    
+    if (g_total.total == 0) {
+        return;
+    }
+    
+    log_histogram(drained ? "POLL to TX complete" : "POLL to write", &g_total);
+    for (int stage = 0; stage < LATENCY_POINTS - 1; stage++) {
+        const char *name = g_stage_names[stage];
+        if (drained && stage == LATENCY_WRITTEN - 1) {
+            name = "Formatted to transmitted";
+        }
+        log_histogram(name, &g_stages[stage]);
+    }
+}
@@ -0,0 +1,99 @@
+/**
+ * CPU load module for Fan Temperature Daemon
+ * Computes CPU utilization from /proc/stat counter deltas so the
+ * controller can react to load before the temperature follows
+ */
+
+#include "load.h"
+#include "config.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+static int g_stat_fd = -1;
+static unsigned long long g_prev_busy = 0;
+static unsigned long long g_prev_total = 0;
+
+/**
+ * Read the aggregate "cpu" line of /proc/stat as busy and total jiffies
+ */
+static int read_cpu_times(unsigned long long *busy, unsigned long long *total) {
+    char buf[256];
+    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
+    
+    // The aggregate line comes first, so a short pread() from offset 0 is enough
+    ssize_t len = pread(g_stat_fd, buf, sizeof(buf) - 1, 0);
+    if (len <= 0) {
+        return -1;
+    }
+    buf[len] = '\0';
+    
+    // guest/guest_nice are already included in user/nice
+    if (sscanf(buf, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+               &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal) != 8) {
+        return -1;
+    }
+    
+    *busy = user + nice + system + irq + softirq + steal;
+    *total = *busy + idle + iowait;
+    return 0;
+}
+
+/**
+ * Open /proc/stat and take the baseline for the first utilization delta
+ */
+int load_init(void) {
+    char path[256];
+    
+    snprintf(path, sizeof(path), "%s/stat", g_config.proc_root);
+    g_stat_fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (g_stat_fd < 0) {
+        LOG_MESSAGE_WARNING("Failed to open %s, CPU load will not be reported: %s", path, strerror(errno));
+        return -1;
+    }
+    
+    if (read_cpu_times(&g_prev_busy, &g_prev_total) != 0) {
+        LOG_MESSAGE_WARNING("Unexpected format of %s, CPU load will not be reported", path);
+        close(g_stat_fd);
+        g_stat_fd = -1;
+        return -1;
+    }
+    
+    LOG_MESSAGE_INFO("CPU load source: %s", path);
+    return 0;
+}
+
+/**
+ * Close /proc/stat
+ */
+void load_cleanup(void) {
+    if (g_stat_fd >= 0) {
+        close(g_stat_fd);
+        g_stat_fd = -1;
+    }
+}
+
+/**
+ * CPU utilization in percent since the previous call
+ * Returns -1 when /proc/stat is not available
+ */
+float load_get_utilization(void) {
+    static float last_utilization = 0.0f;
+    unsigned long long busy, total;
+    
+    if (g_stat_fd < 0 || read_cpu_times(&busy, &total) != 0) {
+        return g_stat_fd < 0 ? -1.0f : last_utilization;
+    }
+    
+    // No jiffies elapsed (calls closer than the tick interval): keep the last value
+    if (total > g_prev_total && busy >= g_prev_busy) {
+        last_utilization = 100.0f * (float)(busy - g_prev_busy) / (float)(total - g_prev_total);
+    }
+    
+    g_prev_busy = busy;
+    g_prev_total = total;
+    return last_utilization;
+}
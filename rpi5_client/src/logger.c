@@ -1,21 +1,211 @@
 /**
  * Logger module for Fan Temperature Daemon
  * Provides unified logging interface for syslog and stdout
+ * Once started, records are formatted at the call site into a lock-free ring
+ * and written by a background thread, so a slow journal never stalls a POLL
  */
 
 #include "logger.h"
+#include "metrics.h"
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <syslog.h>
+#include <sys/eventfd.h>
+
+#define LOGGER_RING_SIZE    256     // Records, a power of two
+#define LOGGER_RECORD_SIZE  480     // Formatted text, longer messages are truncated
+#define LOGGER_LATE_MS      1000    // Syslog records written this late carry their delay
+
+// Preformatted record; sequence is its ring position + 1 once published
+typedef struct {
+    _Atomic uint64_t sequence;
+    int priority;
+    struct timespec timestamp;      // CLOCK_REALTIME at the call site
+    char text[LOGGER_RECORD_SIZE];
+} log_record_t;
 
 static int g_use_syslog = 0;
 
+// Bounded MPSC ring: producers claim positions with a CAS, the writer thread consumes in order
+static log_record_t g_ring[LOGGER_RING_SIZE];
+static _Atomic uint64_t g_head = 0;         // Next position to claim
+static uint64_t g_tail = 0;                 // Next position to write, writer thread only
+
+static pthread_t g_thread;
+static atomic_int g_running = 0;            // Records go through the ring
+static atomic_int g_stop_requested = 0;
+static atomic_int g_writer_idle = 0;        // Writer waits on g_wake_fd, producers must wake it
+static int g_wake_fd = -1;
+
+/**
+ * Level name used on stdout
+ */
+static const char *level_name(int priority) {
+    switch (priority) {
+        case LOG_DEBUG:   return "DEBUG";
+        case LOG_INFO:    return "INFO";
+        case LOG_WARNING: return "WARNING";
+        case LOG_ERR:     return "ERROR";
+        default:          return "UNKNOWN";
+    }
+}
+
+/**
+ * Write one formatted record to syslog or stdout, without flushing stdout
+ */
+static void write_record(int priority, const struct timespec *timestamp, const char *text) {
+    if (g_use_syslog) {
+        // syslog stamps records on arrival; note when that is well after the call
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        long late_ms = (now.tv_sec - timestamp->tv_sec) * 1000L + (now.tv_nsec - timestamp->tv_nsec) / 1000000L;
+        
+        if (late_ms >= LOGGER_LATE_MS) {
+            syslog(priority, "%s (logged %ldms late)", text, late_ms);
+        } else {
+            syslog(priority, "%s", text);
+        }
+    } else {
+        struct tm tm;
+        char stamp[32];
+        
+        localtime_r(&timestamp->tv_sec, &tm);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+        printf("%s.%03ld [%s] %s\n", stamp, timestamp->tv_nsec / 1000000L, level_name(priority), text);
+    }
+}
+
+/**
+ * Claim a ring slot, format the record into it and publish it
+ * Never blocks: a full ring drops the record and counts it
+ */
+static void enqueue(int priority, const struct timespec *timestamp, const char *format, va_list args) {
+    uint64_t position = atomic_load_explicit(&g_head, memory_order_relaxed);
+    log_record_t *record;
+    
+    for (;;) {
+        record = &g_ring[position & (LOGGER_RING_SIZE - 1)];
+        uint64_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+        int64_t diff = (int64_t)(sequence - position);
+        
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g_head, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Slot still holds a record from the previous lap: the writer is behind
+            metrics_inc(METRIC_LOG_DROPS);
+            return;
+        } else {
+            position = atomic_load_explicit(&g_head, memory_order_relaxed);
+        }
+    }
+    
+    record->priority = priority;
+    record->timestamp = *timestamp;
+    vsnprintf(record->text, sizeof(record->text), format, args);
+    atomic_store_explicit(&record->sequence, position + 1, memory_order_release);
+    
+    // Pairs with the fence in wait_for_records(): either the writer sees the record or we see it idle
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_exchange_explicit(&g_writer_idle, 0, memory_order_relaxed)) {
+        eventfd_write(g_wake_fd, 1);
+    }
+}
+
+/**
+ * Whether the record at the tail has been published
+ */
+static int record_ready(void) {
+    log_record_t *record = &g_ring[g_tail & (LOGGER_RING_SIZE - 1)];
+    return atomic_load_explicit(&record->sequence, memory_order_acquire) == g_tail + 1;
+}
+
+/**
+ * Write every published record in order, then report records dropped since the last call
+ */
+static void drain(int64_t *reported_drops) {
+    int wrote = 0;
+    
+    while (record_ready()) {
+        log_record_t *record = &g_ring[g_tail & (LOGGER_RING_SIZE - 1)];
+        
+        write_record(record->priority, &record->timestamp, record->text);
+        atomic_store_explicit(&record->sequence, g_tail + LOGGER_RING_SIZE, memory_order_release);
+        g_tail++;
+        wrote = 1;
+    }
+    
+    int64_t drops = metrics_get(METRIC_LOG_DROPS);
+    if (drops != *reported_drops) {
+        struct timespec now;
+        char text[64];
+        
+        clock_gettime(CLOCK_REALTIME, &now);
+        snprintf(text, sizeof(text), "Log ring full, dropped %lld records", (long long)(drops - *reported_drops));
+        write_record(LOG_WARNING, &now, text);
+        *reported_drops = drops;
+        wrote = 1;
+    }
+    
+    if (wrote && !g_use_syslog) {
+        fflush(stdout);
+    }
+}
+
+/**
+ * Sleep until a producer publishes a record or a stop is requested
+ */
+static void wait_for_records(void) {
+    eventfd_t value;
+    
+    atomic_store_explicit(&g_writer_idle, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (record_ready() || atomic_load(&g_stop_requested)) {
+        atomic_store_explicit(&g_writer_idle, 0, memory_order_relaxed);
+        return;
+    }
+    
+    while (eventfd_read(g_wake_fd, &value) != 0 && errno == EINTR) {
+    }
+}
+
+/**
+ * Writer thread: all log I/O happens here while the logger is started
+ */
+static void *writer_thread(void *arg) {
+    int64_t reported_drops = metrics_get(METRIC_LOG_DROPS);
+    (void)arg;
+    
+    while (!atomic_load(&g_stop_requested)) {
+        drain(&reported_drops);
+        wait_for_records();
+    }
+    
+    // Producers have stopped; write what they left behind
+    drain(&reported_drops);
+    return NULL;
+}
+
 /**
  * Initialize logger
  */
 int logger_init(int use_syslog) {
     g_use_syslog = use_syslog;
     
+    for (uint64_t i = 0; i < LOGGER_RING_SIZE; i++) {
+        atomic_init(&g_ring[i].sequence, i);
+    }
+    
     if (g_use_syslog) {
         openlog("fan_temp_daemon", LOG_PID, LOG_DAEMON);
         logger_log(LOG_INFO, "Fan temperature daemon logging initialized (syslog)");
@@ -26,10 +216,60 @@ int logger_init(int use_syslog) {
     return 0;
 }
 
+/**
+ * Start the writer thread; until then, and if it fails, records are written directly
+ * Call after daemonizing, a forked child would not have the thread
+ */
+int logger_start(void) {
+    g_wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (g_wake_fd < 0) {
+        LOG_MESSAGE_WARNING("Failed to create log writer wakeup, logging synchronously: %s", strerror(errno));
+        return -1;
+    }
+    
+    // Keep every signal off the writer thread; the event loop reads them from a signalfd
+    sigset_t block_all, previous;
+    sigfillset(&block_all);
+    pthread_sigmask(SIG_SETMASK, &block_all, &previous);
+    
+    atomic_store(&g_stop_requested, 0);
+    int result = pthread_create(&g_thread, NULL, writer_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (result != 0) {
+        LOG_MESSAGE_WARNING("Failed to start log writer thread, logging synchronously: %s", strerror(result));
+        close(g_wake_fd);
+        g_wake_fd = -1;
+        return -1;
+    }
+    
+    atomic_store(&g_running, 1);
+    return 0;
+}
+
+/**
+ * Stop the writer thread once it has written every queued record
+ * Other threads must have stopped logging
+ */
+void logger_stop(void) {
+    if (!atomic_load(&g_running)) {
+        return;
+    }
+    
+    atomic_store(&g_stop_requested, 1);
+    eventfd_write(g_wake_fd, 1);
+    pthread_join(g_thread, NULL);
+    atomic_store(&g_running, 0);
+    
+    close(g_wake_fd);
+    g_wake_fd = -1;
+}
+
 /**
  * Cleanup logger
  */
 void logger_cleanup(void) {
+    logger_stop();
+    
     if (g_use_syslog) {
         logger_log(LOG_INFO, "Fan temperature daemon logging cleanup");
         closelog();
@@ -38,28 +278,25 @@ void logger_cleanup(void) {
 
 /**
  * Log message with priority
+ * The timestamp and text are taken here; the write happens on the writer thread once started
  */
 void logger_log(int priority, const char *format, ...) {
+    struct timespec timestamp;
     va_list args;
+    
+    clock_gettime(CLOCK_REALTIME, &timestamp);
     va_start(args, format);
     
-    if (g_use_syslog) {
-        vsyslog(priority, format, args);
+    if (atomic_load_explicit(&g_running, memory_order_acquire)) {
+        enqueue(priority, &timestamp, format, args);
     } else {
-        // Add priority prefix for stdout logging
-        const char *level_str;
-        switch (priority) {
-            case LOG_DEBUG:   level_str = "DEBUG"; break;
-            case LOG_INFO:    level_str = "INFO"; break;
-            case LOG_WARNING: level_str = "WARNING"; break;
-            case LOG_ERR:     level_str = "ERROR"; break;
-            default:          level_str = "UNKNOWN"; break;
-        }
+        char text[LOGGER_RECORD_SIZE];
         
-        printf("[%s] ", level_str);
-        vprintf(format, args);
-        printf("\n");
-        fflush(stdout);
+        vsnprintf(text, sizeof(text), format, args);
+        write_record(priority, &timestamp, text);
+        if (!g_use_syslog) {
+            fflush(stdout);
+        }
     }
     
     va_end(args);
@@ -8,176 +8,770 @@
 #include "daemon.h"
 #include "serial.h"
 #include "temperature.h"
+#include "sampler.h"
+#include "load.h"
+#include "response.h"
+#include "hotplug.h"
+#include "latency.h"
+#include "metrics.h"
+#include "event_loop.h"
 #include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define ERROR_BACKOFF_MS      100   // Pause reading after a serial error
+#define RECONNECT_DELAY_MS    5000  // Retry interval when the serial port exists but cannot be opened
+#define ERROR_RECONNECT_DELAY_MS 1000  // Pause before reopening a port that keeps failing
+#define MAX_CONSECUTIVE_ERRORS 5
+#define BAUD_TRIAL_MS         2000  // A negotiated rate not committed within this time is reverted
+#define BAUD_FALLBACK_MS      5000  // Without a valid command for this long, return to the configured rate
+#define STATS_INTERVAL_MS     300000  // Log response latency every 5 minutes
+#define PUSH_REPEAT_MS        50    // Repeat an unacknowledged push update after this long
+#define PUSH_REPEATS          5     // Repeats per update, spanning the controller's listen rotation
+#define PUSH_MAX_UNACKED      3     // Updates without ACK before push mode is left
+
+// Push update format negotiated by the controller
+typedef enum {
+    PUSH_OFF = 0,
+    PUSH_TEXT,              // Same line as a POLL:EXT response
+    PUSH_BINARY             // Same frame as a POLL:BIN response
+} push_format_t;
+
+// Serial session state, owned by the event loop
+static struct {
+    int fd;
+    int timer_fd;           // One-shot: error backoff or reconnect retry
+    int tick_fd;            // Periodic: read timeout accounting and health check
+    int signal_fd;
+    int consecutive_errors;
+    int consecutive_timeouts;
+    int successful_exchanges;
+    int startup_sync_mode;  // Flag to ignore incomplete commands during startup
+    int received_since_tick;
+    int64_t connected_ns;   // When the port was opened, to time the first answered POLL
+    int baud_timer_fd;      // One-shot: end of a negotiated rate's trial
+    int baud_rate;          // Rate currently applied to the port
+    int baud_trial_from;    // Rate to revert to while a negotiated rate is on trial, 0 otherwise
+    int64_t last_valid_ns;  // Last recognized command, for the fallback to the configured rate
+    int stats_fd;           // Periodic: response latency statistics
+    int hotplug_fd;         // inotify on the serial device path, -1 if unavailable
+    int metrics_fd;         // Listening metrics socket, -1 if disabled
+    int metrics_timer_fd;   // Periodic: metrics textfile rewrite, -1 if disabled
+} g_session = {-1, -1, -1, -1, 0, 0, 0, 1, 0, 0, -1, 0, 0, 0, -1, -1, -1, -1};
+
+// Push mode: updates sent without a POLL on a significant change or heartbeat
+static struct {
+    push_format_t format;
+    int timer_fd;           // One-shot: next repeat of the current update, or heartbeat
+    int notify_fd;          // Sampler notification, -1 if push mode is not available
+    int repeats_left;       // Repeats of the current update, 0 once acknowledged
+    int unacked;            // Consecutive updates without ACK
+    float sent_cpu;         // Temperatures of the last response, pushed or polled
+    float sent_nvme;
+} g_push = {PUSH_OFF, -1, -1, 0, 0, 0.0f, 0.0f};
+
+// Encoded POLL response, refreshed when the sampled values change
+static response_t g_response;
+
+static void on_serial_event(int fd, uint32_t events, void *data);
 
 /**
- * Main daemon loop
+ * Answer a POLL with the latest sampled temperatures, as text or as a binary frame
+ * Push updates are sent the same way, unsolicited
  */
-static void run_main_loop(void) {
-    char buffer[256];
-    char temp_data[64];
-    int consecutive_errors = 0;
-    int consecutive_timeouts = 0;
-    int successful_exchanges = 0;
-    int startup_sync_mode = 1;  // Flag to ignore incomplete commands during startup
-    int serial_fd;
+static void send_temperatures(int serial_fd, response_format_t format, int unsolicited) {
+    // Exit startup sync mode on first valid POLL command
+    if (g_session.startup_sync_mode) {
+        g_session.startup_sync_mode = 0;
+        LOG_MESSAGE_INFO("Serial synchronization established after %.1fms - normal operation begins",
+                         (utils_monotonic_ns() - g_session.connected_ns) / 1e6);
+    }
     
-    // Open and configure serial port
-    serial_fd = serial_setup(g_config.serial_port, g_config.baud_rate);
-    if (serial_fd < 0) {
-        LOG_MESSAGE_ERR("Failed to open serial port %s", g_config.serial_port);
-        return;
+    // Get latest temperatures from the sampler (never blocks on sensors)
+    temperature_snapshot_t snapshot;
+    sampler_get_snapshot(&snapshot);
+    latency_mark(LATENCY_SAMPLED);
+    
+    // Re-encode only if a reported value changed, then fill in the sample age
+    response_update(&g_response, &snapshot, g_config.trend_samples > 0);
+    g_push.sent_cpu = snapshot.cpu_temp;
+    g_push.sent_nvme = snapshot.nvme_temp;
+    response_set_age(&g_response, sampler_snapshot_age_ms(&snapshot));
+    
+    // Send temperature data; a plain POLL gets the line without the optional fields
+    struct iovec frame = {g_response.frame, 0};
+    struct iovec plain[RESPONSE_IOV_COUNT] = {g_response.iov[0], g_response.iov[1], {(void *)"\n", 1}};
+    const struct iovec *iov = format == RESPONSE_TEXT_EXTENDED ? g_response.iov : plain;
+    int count = RESPONSE_IOV_COUNT;
+    if (format == RESPONSE_BINARY) {
+        frame.iov_len = response_encode_frame(&g_response, sampler_snapshot_age_ms(&snapshot));
+        iov = &frame;
+        count = 1;
     }
+    latency_mark(LATENCY_FORMATTED);
+    int sent = unsolicited ? serial_push_iov(serial_fd, iov, count) : serial_send_iov(serial_fd, iov, count);
     
-    // Log startup information
-    const char *baud_str = "unknown";
-    switch (g_config.baud_rate) {
-        case B9600:   baud_str = "9600"; break;
-        case B19200:  baud_str = "19200"; break;
-        case B38400:  baud_str = "38400"; break;
-        case B57600:  baud_str = "57600"; break;
-        case B115200: baud_str = "115200"; break;
+    if (g_config.verbose) {
+        LOG_MESSAGE_DEBUG("%s%s: %.*s%.*s%.*s (bytes: %d)",
+                          unsolicited ? "Pushed" : "Sent", format == RESPONSE_BINARY ? " as binary frame" : "",
+                          (int)g_response.iov[0].iov_len, g_response.head,
+                          (int)g_response.iov[1].iov_len, g_response.age,
+                          format == RESPONSE_TEXT ? 0 : (int)g_response.iov[2].iov_len - 1, g_response.tail, sent);
     }
     
-    LOG_MESSAGE_INFO("Temperature monitoring started on %s (baud: %s, timeout: %ds)", 
-             g_config.serial_port, baud_str, g_config.read_timeout_sec);
+    // Count successful exchange
+    if (!unsolicited) {
+        metrics_inc(METRIC_POLLS);
+    }
+    g_session.successful_exchanges++;
     
-    // Main loop
-    while (g_running) {
-        // Check connection health only after many consecutive timeouts
-        if (consecutive_timeouts > 30 && successful_exchanges == 0) {
-            if (!serial_check_health(serial_fd)) {
-                LOG_MESSAGE_WARNING("Serial port health check failed after %d timeouts, attempting reconnection", consecutive_timeouts);
-                serial_close(serial_fd);
-                
-                serial_fd = serial_setup(g_config.serial_port, g_config.baud_rate);
-                if (serial_fd < 0) {
-                    LOG_MESSAGE_ERR("Failed to reconnect to serial port");
-                    sleep(5);  // Wait before retry
-                    continue;
-                }
-                consecutive_errors = 0;
-                consecutive_timeouts = 0;
-                startup_sync_mode = 1;
-                utils_sleep_ms(500);  // 500ms stabilization delay
-            }
+    // Reset successful exchanges counter periodically
+    if (g_session.successful_exchanges > 10) {
+        g_session.successful_exchanges = 1;
+    }
+}
+
+/**
+ * Switch to another baud rate, returning to the previous one if it cannot be applied
+ */
+static int switch_baud(int serial_fd, int rate) {
+    if (serial_set_baud(serial_fd, rate) != 0) {
+        serial_set_baud(serial_fd, g_session.baud_rate);
+        return -1;
+    }
+    
+    g_session.baud_rate = rate;
+    return 0;
+}
+
+/**
+ * Baud rate negotiation, driven by the controller
+ * BAUD:<rate> is acknowledged at the current rate, then the port switches and
+ * the rate is on trial: the controller tests it with ECHO lines and confirms with
+ * BAUD:COMMIT. Without confirmation the previous rate is restored
+ */
+static void handle_baud(int serial_fd, const char *argument) {
+    char reply[32];
+    
+    if (strcmp(argument, "COMMIT") == 0) {
+        if (g_session.baud_trial_from != 0) {
+            event_loop_arm_timer(g_session.baud_timer_fd, 0, 0);
+            g_session.baud_trial_from = 0;
+            LOG_MESSAGE_INFO("Baud rate %d negotiated", g_session.baud_rate);
+        }
+        serial_send_data(serial_fd, "BAUD:OK\n");
+        return;
+    }
+    
+    int rate = config_parse_baud_rate(argument);
+    if (rate == 0 || rate > g_config.baud_max) {
+        snprintf(reply, sizeof(reply), "BAUD:NO:%d\n", g_config.baud_max);
+        serial_send_data(serial_fd, reply);
+        if (g_config.verbose) {
+            LOG_MESSAGE_DEBUG("Refused baud rate '%s' (maximum %d)", argument, g_config.baud_max);
         }
+        return;
+    }
+    
+    snprintf(reply, sizeof(reply), "BAUD:OK:%d\n", rate);
+    serial_send_data(serial_fd, reply);
+    
+    int previous = g_session.baud_trial_from != 0 ? g_session.baud_trial_from : g_session.baud_rate;
+    if (switch_baud(serial_fd, rate) != 0) {
+        return;  // Still at the previous rate, the controller's echo test fails
+    }
+    
+    g_session.baud_trial_from = previous;
+    event_loop_arm_timer(g_session.baud_timer_fd, BAUD_TRIAL_MS, 0);
+    
+    if (g_config.verbose) {
+        LOG_MESSAGE_DEBUG("Trying baud rate %d (previous %d)", rate, previous);
+    }
+}
+
+/**
+ * Wire format negotiation: PROTO:BIN or PROTO:EXT is confirmed, after which the
+ * controller may poll with POLL:BIN or POLL:EXT. The daemon keeps no state, so a
+ * restart cannot leave the two ends disagreeing about the format
+ */
+static void handle_proto(int serial_fd, const char *argument) {
+    if (strcmp(argument, "BIN") == 0) {
+        serial_send_data(serial_fd, "PROTO:OK:BIN\n");
+    } else if (strcmp(argument, "EXT") == 0) {
+        serial_send_data(serial_fd, "PROTO:OK:EXT\n");
+    } else {
+        serial_send_data(serial_fd, "PROTO:NO\n");
+    }
+}
+
+/**
+ * Leave push mode; the controller goes back to polling
+ */
+static void push_stop(void) {
+    g_push.format = PUSH_OFF;
+    g_push.repeats_left = 0;
+    event_loop_arm_timer(g_push.timer_fd, 0, 0);
+}
+
+/**
+ * Send a new push update, to be repeated until the controller acknowledges it
+ * SoftwareSerial on the controller listens to one device at a time, so a single
+ * update may arrive while it listens elsewhere
+ */
+static void push_update(int serial_fd) {
+    send_temperatures(serial_fd, g_push.format == PUSH_BINARY ? RESPONSE_BINARY : RESPONSE_TEXT_EXTENDED, 1);
+    metrics_inc(METRIC_PUSH_UPDATES);
+    g_push.repeats_left = PUSH_REPEATS;
+    event_loop_arm_timer(g_push.timer_fd, PUSH_REPEAT_MS, 0);
+}
+
+/**
+ * Push mode control: PUSH:ON or PUSH:BIN starts updates in text or binary format
+ * and is answered with the heartbeat interval, PUSH:OFF returns to polling only
+ */
+static void handle_push(int serial_fd, const char *argument) {
+    char reply[32];
+    
+    if (strcmp(argument, "OFF") == 0) {
+        push_stop();
+        serial_send_data(serial_fd, "PUSH:OK:OFF\n");
+        return;
+    }
+    
+    if ((strcmp(argument, "ON") != 0 && strcmp(argument, "BIN") != 0) ||
+        g_config.push_delta <= 0 || g_push.notify_fd < 0) {
+        serial_send_data(serial_fd, "PUSH:NO\n");
+        return;
+    }
+    
+    g_push.format = strcmp(argument, "BIN") == 0 ? PUSH_BINARY : PUSH_TEXT;
+    g_push.repeats_left = 0;
+    g_push.unacked = 0;
+    event_loop_arm_timer(g_push.timer_fd, g_config.push_heartbeat_ms, 0);
+    
+    snprintf(reply, sizeof(reply), "PUSH:OK:%d\n", g_config.push_heartbeat_ms);
+    serial_send_data(serial_fd, reply);
+    LOG_MESSAGE_INFO("Push mode enabled (%s, delta %.2f, heartbeat %dms)",
+                     g_push.format == PUSH_BINARY ? "binary" : "text",
+                     g_config.push_delta, g_config.push_heartbeat_ms);
+}
+
+/**
+ * The controller received the current push update: stop repeating it
+ */
+static void handle_ack(void) {
+    if (g_push.format == PUSH_OFF) {
+        return;
+    }
+    
+    g_push.unacked = 0;
+    if (g_push.repeats_left > 0) {
+        g_push.repeats_left = 0;
+        event_loop_arm_timer(g_push.timer_fd, g_config.push_heartbeat_ms, 0);
+    }
+}
+
+/**
+ * Handle one batch of commands received from the fan controller
+ */
+static void handle_commands(int serial_fd, const serial_batch_t *batch) {
+    for (int i = 0; i < batch->count; i++) {
+        const serial_command_t *command = &batch->commands[i];
         
-        // Wait for a command from the fan controller
-        int bytes_read = serial_read_complete_command(serial_fd, buffer, sizeof(buffer), g_config.read_timeout_sec);
+        if (command->type != SERIAL_COMMAND_UNKNOWN) {
+            g_session.last_valid_ns = utils_monotonic_ns();
+        }
         
-        if (bytes_read > 0) {
-            buffer[bytes_read] = '\0';
-            consecutive_errors = 0;
-            consecutive_timeouts = 0;
-            
+        if (command->type == SERIAL_COMMAND_POLL) {
+            send_temperatures(serial_fd, RESPONSE_TEXT, 0);
+        } else if (command->type == SERIAL_COMMAND_POLL_EXTENDED) {
+            send_temperatures(serial_fd, RESPONSE_TEXT_EXTENDED, 0);
+        } else if (command->type == SERIAL_COMMAND_POLL_BINARY) {
+            send_temperatures(serial_fd, RESPONSE_BINARY, 0);
+        } else if (command->type == SERIAL_COMMAND_PROTO) {
+            handle_proto(serial_fd, command->text + 6);
+        } else if (command->type == SERIAL_COMMAND_PUSH) {
+            handle_push(serial_fd, command->text + 5);
+        } else if (command->type == SERIAL_COMMAND_ACK) {
+            handle_ack();
+        } else if (command->type == SERIAL_COMMAND_BAUD) {
+            handle_baud(serial_fd, command->text + 5);
+        } else if (command->type == SERIAL_COMMAND_ECHO) {
+            char reply[SERIAL_COMMAND_MAX + 1];
+            snprintf(reply, sizeof(reply), "%s\n", command->text);
+            serial_send_data(serial_fd, reply);
+        } else if (g_session.startup_sync_mode) {
+            // During startup, ignore unknown commands
+            metrics_inc(METRIC_UNKNOWN_COMMANDS);
             if (g_config.verbose) {
-                LOG_MESSAGE_DEBUG("Received command: '%s' (length: %d)", buffer, bytes_read);
+                LOG_MESSAGE_DEBUG("Unknown command during startup sync: '%s' - ignoring", command->text);
             }
-            
-            // Clean the buffer before comparison
-            utils_clean_buffer(buffer);
-            
+        } else {
+            // Normal mode - log unknown commands
+            metrics_inc(METRIC_UNKNOWN_COMMANDS);
             if (g_config.verbose) {
-                LOG_MESSAGE_DEBUG("Cleaned command: '%s'", buffer);
+                LOG_MESSAGE_DEBUG("Unknown command received: '%s'", command->text);
             }
-            
-            if (strcmp(buffer, "POLL") == 0) {
-                // Exit startup sync mode on first valid POLL command
-                if (startup_sync_mode) {
-                    startup_sync_mode = 0;
-                    LOG_MESSAGE_INFO("Serial synchronization established - normal operation begins");
-                }
-                
-                // Get current temperatures
-                float cpu_temp = temperature_get_cpu(g_config.cpu_temp_cmd);
-                float nvme_temp = temperature_get_nvme(g_config.nvme_temp_cmd);
-                
-                // Format temperature data
-                int formatted = temperature_format_response(temp_data, sizeof(temp_data), cpu_temp, nvme_temp);
-                
-                if (formatted > 0) {
-                    // Send temperature data
-                    int sent = serial_send_data(serial_fd, temp_data);
-                    
-                    if (g_config.verbose) {
-                        LOG_MESSAGE_DEBUG("Sent: %s (bytes: %d)", temp_data, sent);
-                    }
-                    
-                    // Count successful exchange
-                    successful_exchanges++;
-                    
-                    // Reset successful exchanges counter periodically
-                    if (successful_exchanges > 10) {
-                        successful_exchanges = 1;
-                    }
-                } else {
-                    LOG_MESSAGE_ERR("Failed to format temperature response");
-                }
-            } else if (strlen(buffer) == 0) {
-                // Empty message - ignore silently
-                if (g_config.verbose) {
-                    LOG_MESSAGE_DEBUG("Received empty message - ignoring");
-                }
+        }
+    }
+}
+
+/**
+ * Open the serial port and start watching it
+ */
+static int serial_connect(void) {
+    g_session.connected_ns = utils_monotonic_ns();
+    g_session.fd = serial_setup(g_config.serial_port, g_config.baud_rate);
+    if (g_session.fd < 0) {
+        return -1;
+    }
+    
+    if (event_loop_add(g_session.fd, EPOLLIN, on_serial_event, NULL) != 0) {
+        serial_close(g_session.fd);
+        g_session.fd = -1;
+        return -1;
+    }
+    
+    g_session.consecutive_errors = 0;
+    g_session.consecutive_timeouts = 0;
+    g_session.startup_sync_mode = 1;
+    g_session.baud_rate = g_config.baud_rate;
+    g_session.baud_trial_from = 0;
+    g_session.last_valid_ns = g_session.connected_ns;
+    return 0;
+}
+
+/**
+ * Stop watching and close the serial port
+ */
+static void serial_disconnect(void) {
+    if (g_session.fd >= 0) {
+        event_loop_remove(g_session.fd);
+        serial_close(g_session.fd);
+        g_session.fd = -1;
+    }
+    event_loop_arm_timer(g_session.timer_fd, 0, 0);
+    event_loop_arm_timer(g_session.baud_timer_fd, 0, 0);
+    push_stop();
+}
+
+/**
+ * Close and reopen the serial port, retrying later instead of waiting when it fails
+ */
+static void serial_reconnect(void) {
+    metrics_inc(METRIC_RECONNECTS);
+    serial_disconnect();
+    
+    if (serial_connect() == 0) {
+        return;
+    }
+    
+    // A missing device is reopened when the hotplug watch sees it return
+    if (g_session.hotplug_fd >= 0 && !hotplug_device_present()) {
+        LOG_MESSAGE_WARNING("Serial port %s not present, waiting for it to appear", g_config.serial_port);
+    } else {
+        LOG_MESSAGE_ERR("Failed to reconnect to serial port, retrying in %dms", RECONNECT_DELAY_MS);
+        event_loop_arm_timer(g_session.timer_fd, RECONNECT_DELAY_MS, 0);
+    }
+}
+
+/**
+ * Serial port readable: process every complete command that has arrived
+ */
+static void on_serial_event(int fd, uint32_t events, void *data) {
+    serial_batch_t batch;
+    (void)data;
+    
+    int bytes_read = (events & EPOLLIN) ? serial_read_available(fd) : -1;
+    int read_errno = errno;
+    if (bytes_read < 0 || (events & (EPOLLERR | EPOLLHUP))) {
+        g_session.consecutive_errors++;
+        g_session.successful_exchanges = 0;
+        metrics_inc(METRIC_SERIAL_ERRORS);
+        
+        if (g_config.verbose) {
+            if (events & (EPOLLERR | EPOLLHUP)) {
+                LOG_MESSAGE_WARNING("Serial port reported%s%s (error count: %d)",
+                                    (events & EPOLLERR) ? " EPOLLERR" : "", (events & EPOLLHUP) ? " EPOLLHUP" : "",
+                                    g_session.consecutive_errors);
             } else {
-                // Handle non-empty unknown commands
-                if (startup_sync_mode) {
-                    // During startup, ignore unknown commands
-                    if (g_config.verbose) {
-                        LOG_MESSAGE_DEBUG("Unknown command during startup sync: '%s' - ignoring", buffer);
-                    }
-                } else {
-                    // Normal mode - log unknown commands
-                    if (g_config.verbose) {
-                        LOG_MESSAGE_DEBUG("Unknown command received: '%s'", buffer);
-                    }
-                }
-            }
-        } else if (bytes_read < 0) {
-            consecutive_errors++;
-            successful_exchanges = 0;
-            
-            if (g_config.verbose) {
-                LOG_MESSAGE_WARNING("Error reading from serial port: %s (error count: %d)", 
-                           strerror(errno), consecutive_errors);
-            }
-            
-            // If too many consecutive errors, try to reconnect
-            if (consecutive_errors >= 5) {
-                LOG_MESSAGE_WARNING("Too many consecutive errors, attempting reconnection");
-                serial_close(serial_fd);
-                
-                serial_fd = serial_setup(g_config.serial_port, g_config.baud_rate);
-                if (serial_fd < 0) {
-                    LOG_MESSAGE_ERR("Failed to reconnect to serial port");
-                    sleep(5);  // Wait before retry
-                    continue;
-                }
-                consecutive_errors = 0;
-                consecutive_timeouts = 0;
-                startup_sync_mode = 1;
-                utils_sleep_ms(500);  // 500ms stabilization delay
+                LOG_MESSAGE_WARNING("Error reading from serial port: %s (error count: %d)",
+                                    strerror(read_errno), g_session.consecutive_errors);
             }
-            
-            // Sleep briefly to avoid tight loop on error
-            utils_sleep_ms(100);
+        }
+        
+        // If too many consecutive errors, close the port and reopen it after a pause
+        if (g_session.consecutive_errors >= MAX_CONSECUTIVE_ERRORS) {
+            LOG_MESSAGE_WARNING("Too many consecutive errors, reconnecting in %dms", ERROR_RECONNECT_DELAY_MS);
+            serial_disconnect();
+            event_loop_arm_timer(g_session.timer_fd, ERROR_RECONNECT_DELAY_MS, 0);
+            return;
+        }
+        
+        // Stop watching briefly to avoid a tight loop on a persistent error; epoll reports
+        // EPOLLHUP and EPOLLERR whatever the event mask, so the fd has to leave the set
+        event_loop_remove(fd);
+        event_loop_arm_timer(g_session.timer_fd, ERROR_BACKOFF_MS, 0);
+        return;
+    }
+    
+    if (bytes_read > 0) {
+        g_session.consecutive_errors = 0;
+        g_session.consecutive_timeouts = 0;
+        g_session.received_since_tick = 1;
+    }
+    
+    // Answer everything that arrived before waiting again
+    while (serial_next_batch(&batch) > 0) {
+        handle_commands(fd, &batch);
+    }
+}
+
+/**
+ * One-shot serial timer: end of error backoff, or reconnect retry
+ */
+static void on_serial_timer(int fd, uint32_t events, void *data) {
+    (void)events;
+    (void)data;
+    
+    event_loop_read_timer(fd);
+    
+    if (g_session.fd < 0) {
+        serial_reconnect();
+    } else if (event_loop_add(g_session.fd, EPOLLIN, on_serial_event, NULL) != 0) {
+        serial_reconnect();
+    }
+}
+
+/**
+ * Trial of a negotiated baud rate expired without BAUD:COMMIT
+ */
+static void on_baud_timer(int fd, uint32_t events, void *data) {
+    (void)events;
+    (void)data;
+    
+    event_loop_read_timer(fd);
+    
+    if (g_session.fd >= 0 && g_session.baud_trial_from != 0) {
+        LOG_MESSAGE_WARNING("Baud rate %d not confirmed, returning to %d",
+                            g_session.baud_rate, g_session.baud_trial_from);
+        switch_baud(g_session.fd, g_session.baud_trial_from);
+        g_session.baud_trial_from = 0;
+    }
+}
+
+/**
+ * Return to the configured baud rate when a negotiated one has gone silent
+ */
+static void check_baud_fallback(void) {
+    if (g_session.fd < 0 || g_session.baud_trial_from != 0 || g_session.baud_rate == g_config.baud_rate) {
+        return;
+    }
+    
+    // In push mode the controller only acknowledges updates, at least once per heartbeat
+    int silence_ms = BAUD_FALLBACK_MS + (g_push.format != PUSH_OFF ? 2 * g_config.push_heartbeat_ms : 0);
+    
+    if (utils_monotonic_ns() - g_session.last_valid_ns > (int64_t)silence_ms * 1000000) {
+        LOG_MESSAGE_WARNING("No valid command at %d baud for %dms, returning to %d",
+                            g_session.baud_rate, silence_ms, g_config.baud_rate);
+        metrics_inc(METRIC_BAUD_FALLBACKS);
+        push_stop();
+        switch_baud(g_session.fd, g_config.baud_rate);
+    }
+}
+
+/**
+ * Read timeout tick: count silent intervals and check the connection after many
+ */
+static void on_tick(int fd, uint32_t events, void *data) {
+    (void)events;
+    (void)data;
+    
+    event_loop_read_timer(fd);
+    
+    check_baud_fallback();
+    
+    if (g_session.received_since_tick) {
+        g_session.received_since_tick = 0;
+        return;
+    }
+    
+    // Timeout occurred - this is normal
+    g_session.consecutive_timeouts++;
+    metrics_inc(METRIC_SERIAL_TIMEOUTS);
+    
+    if (g_config.verbose && (g_session.consecutive_timeouts % 10 == 1)) {
+        LOG_MESSAGE_DEBUG("Timeout waiting for data from serial port (count: %d)", g_session.consecutive_timeouts);
+    }
+    
+    // Check connection health only after many consecutive timeouts
+    if (g_session.fd >= 0 && g_session.consecutive_timeouts > 30 && g_session.successful_exchanges == 0) {
+        if (!serial_check_health(g_session.fd)) {
+            LOG_MESSAGE_WARNING("Serial port health check failed after %d timeouts, attempting reconnection",
+                                g_session.consecutive_timeouts);
+            serial_reconnect();
+        }
+    }
+}
+
+/**
+ * Serial device node added, removed or changed
+ */
+static void on_hotplug(int fd, uint32_t events, void *data) {
+    (void)events;
+    (void)data;
+    
+    int changes = hotplug_read(fd);
+    if (changes == 0) {
+        return;
+    }
+    
+    if (!hotplug_device_present()) {
+        if (g_session.fd >= 0) {
+            LOG_MESSAGE_WARNING("Serial port %s removed", g_config.serial_port);
+            serial_disconnect();
+        }
+        return;
+    }
+    
+    // Reopen when the device appears, or when it was replaced while the old fd was open
+    if (g_session.fd < 0) {
+        LOG_MESSAGE_INFO("Serial port %s appeared, reconnecting", g_config.serial_port);
+        serial_reconnect();
+    } else if (changes & HOTPLUG_CREATED) {
+        LOG_MESSAGE_INFO("Serial port %s replaced, reconnecting", g_config.serial_port);
+        serial_reconnect();
+    }
+}
+
+/**
+ * New sample published: push it if a temperature moved by the configured delta
+ */
+static void on_sample(int fd, uint32_t events, void *data) {
+    eventfd_t samples;
+    temperature_snapshot_t snapshot;
+    (void)events;
+    (void)data;
+    
+    eventfd_read(fd, &samples);
+    if (g_session.fd < 0 || g_push.format == PUSH_OFF) {
+        return;
+    }
+    
+    sampler_get_snapshot(&snapshot);
+    float cpu_change = snapshot.cpu_temp - g_push.sent_cpu;
+    float nvme_change = snapshot.nvme_temp - g_push.sent_nvme;
+    
+    if (cpu_change >= g_config.push_delta || -cpu_change >= g_config.push_delta ||
+        nvme_change >= g_config.push_delta || -nvme_change >= g_config.push_delta) {
+        push_update(g_session.fd);
+    }
+}
+
+/**
+ * Push timer: repeat the unacknowledged update, or send the heartbeat
+ */
+static void on_push_timer(int fd, uint32_t events, void *data) {
+    (void)events;
+    (void)data;
+    
+    event_loop_read_timer(fd);
+    if (g_session.fd < 0 || g_push.format == PUSH_OFF) {
+        return;
+    }
+    
+    if (g_push.repeats_left == 0) {
+        push_update(g_session.fd);
+        return;
+    }
+    
+    send_temperatures(g_session.fd, g_push.format == PUSH_BINARY ? RESPONSE_BINARY : RESPONSE_TEXT_EXTENDED, 1);
+    metrics_inc(METRIC_PUSH_REPEATS);
+    if (--g_push.repeats_left > 0) {
+        event_loop_arm_timer(fd, PUSH_REPEAT_MS, 0);
+        return;
+    }
+    
+    // Repeats exhausted: the controller is gone or has stopped listening
+    if (++g_push.unacked >= PUSH_MAX_UNACKED) {
+        LOG_MESSAGE_WARNING("%d push updates not acknowledged, leaving push mode", g_push.unacked);
+        push_stop();
+        return;
+    }
+    event_loop_arm_timer(fd, g_config.push_heartbeat_ms, 0);
+}
+
+/**
+ * Log response latency per stage and push mode counters
+ */
+static void log_stats(void) {
+    latency_log_stats();
+    
+    if (metrics_get(METRIC_PUSH_UPDATES) > 0) {
+        LOG_MESSAGE_INFO("Push updates: %lld sent, %lld repeated until acknowledged",
+                         (long long)metrics_get(METRIC_PUSH_UPDATES), (long long)metrics_get(METRIC_PUSH_REPEATS));
+    }
+}
+
+/**
+ * Statistics tick: log the response latency achieved
+ */
+static void on_stats(int fd, uint32_t events, void *data) {
+    (void)events;
+    (void)data;
+    
+    event_loop_read_timer(fd);
+    log_stats();
+}
+
+/**
+ * Copy the state owned by the event loop into the gauges before an export
+ */
+static void update_gauges(void) {
+    temperature_snapshot_t snapshot;
+    
+    metrics_set(METRIC_CONNECTED, g_session.fd >= 0);
+    metrics_set(METRIC_BAUD_RATE, g_session.fd >= 0 ? g_session.baud_rate : 0);
+    metrics_set(METRIC_CONSECUTIVE_ERRORS, g_session.consecutive_errors);
+    metrics_set(METRIC_CONSECUTIVE_TIMEOUTS, g_session.consecutive_timeouts);
+    metrics_set(METRIC_SUCCESSFUL_EXCHANGES, g_session.successful_exchanges);
+    metrics_set(METRIC_PUSH_ACTIVE, g_push.format != PUSH_OFF);
+    
+    sampler_get_snapshot(&snapshot);
+    metrics_set(METRIC_CPU_MILLIDEGREES, (int64_t)(snapshot.cpu_temp * 1000.0f + 0.5f));
+    metrics_set(METRIC_NVME_MILLIDEGREES, (int64_t)(snapshot.nvme_temp * 1000.0f + 0.5f));
+}
+
+/**
+ * Metrics socket readable: answer the waiting clients
+ */
+static void on_metrics_client(int fd, uint32_t events, void *data) {
+    (void)events;
+    (void)data;
+    
+    update_gauges();
+    metrics_serve(fd);
+}
+
+/**
+ * Metrics tick: rewrite the textfile
+ */
+static void on_metrics_timer(int fd, uint32_t events, void *data) {
+    (void)events;
+    (void)data;
+    
+    event_loop_read_timer(fd);
+    update_gauges();
+    metrics_write_textfile(g_config.metrics_textfile);
+}
+
+/**
+ * Signal delivered through the signalfd
+ */
+static void on_signal(int fd, uint32_t events, void *data) {
+    int sig;
+    (void)events;
+    (void)data;
+    
+    while ((sig = event_loop_read_signal(fd)) > 0) {
+        if (sig == SIGUSR1) {
+            // Dump the latency histograms on demand
+            log_stats();
         } else {
-            // Timeout occurred - this is normal
-            consecutive_timeouts++;
-            
-            if (g_config.verbose && (consecutive_timeouts % 10 == 1)) {
-                LOG_MESSAGE_DEBUG("Timeout waiting for data from serial port (count: %d)", consecutive_timeouts);
-            }
+            daemon_signal_handler(sig);
         }
     }
     
+    if (!g_running) {
+        event_loop_stop();
+    }
+}
+
+/**
+ * Main daemon loop
+ */
+static void run_main_loop(const sigset_t *signals) {
+    if (event_loop_init() != 0) {
+        return;
+    }
+    
+    response_init(&g_response);
+    
+    g_session.timer_fd = event_loop_add_timer(on_serial_timer, NULL);
+    g_session.tick_fd = event_loop_add_timer(on_tick, NULL);
+    g_session.baud_timer_fd = event_loop_add_timer(on_baud_timer, NULL);
+    g_session.stats_fd = event_loop_add_timer(on_stats, NULL);
+    g_push.timer_fd = event_loop_add_timer(on_push_timer, NULL);
+    g_session.signal_fd = event_loop_add_signals(signals, on_signal, NULL);
+    if (g_session.timer_fd < 0 || g_session.tick_fd < 0 || g_session.baud_timer_fd < 0 ||
+        g_session.stats_fd < 0 || g_push.timer_fd < 0 || g_session.signal_fd < 0) {
+        event_loop_cleanup();
+        return;
+    }
+    
+    // Push mode reacts to new samples as they are published
+    int notify_fd = sampler_notify_fd();
+    if (g_config.push_delta > 0 && notify_fd >= 0 && event_loop_add(notify_fd, EPOLLIN, on_sample, NULL) == 0) {
+        g_push.notify_fd = notify_fd;
+    }
+    
+    // Watch the device path so removal and re-creation are handled immediately
+    g_session.hotplug_fd = hotplug_init(g_config.serial_port);
+    if (g_session.hotplug_fd >= 0 && event_loop_add(g_session.hotplug_fd, EPOLLIN, on_hotplug, NULL) != 0) {
+        hotplug_cleanup();
+        g_session.hotplug_fd = -1;
+    }
+    
+    // Metrics endpoints are optional; the daemon runs without the ones that fail
+    if (g_config.metrics_socket != NULL) {
+        g_session.metrics_fd = metrics_listen(g_config.metrics_socket);
+        if (g_session.metrics_fd >= 0 &&
+            event_loop_add(g_session.metrics_fd, EPOLLIN, on_metrics_client, NULL) != 0) {
+            metrics_close(g_session.metrics_fd, g_config.metrics_socket);
+            g_session.metrics_fd = -1;
+        }
+    }
+    if (g_config.metrics_textfile != NULL) {
+        g_session.metrics_timer_fd = event_loop_add_timer(on_metrics_timer, NULL);
+        event_loop_arm_timer(g_session.metrics_timer_fd, g_config.metrics_interval_ms, g_config.metrics_interval_ms);
+    }
+    
+    // Open and configure serial port; a device that is not plugged in yet is waited for
+    if (serial_connect() != 0) {
+        if (g_session.hotplug_fd < 0 || hotplug_device_present()) {
+            LOG_MESSAGE_ERR("Failed to open serial port %s", g_config.serial_port);
+            hotplug_cleanup();
+            metrics_close(g_session.metrics_fd, g_config.metrics_socket);
+            event_loop_cleanup();
+            return;
+        }
+        LOG_MESSAGE_WARNING("Serial port %s not present, waiting for it to appear", g_config.serial_port);
+    }
+    
+    // Log startup information
+    LOG_MESSAGE_INFO("Temperature monitoring started on %s (baud: %d, timeout: %ds)",
+             g_config.serial_port, g_config.baud_rate, g_config.read_timeout_sec);
+    
+    int tick_ms = g_config.read_timeout_sec * 1000;
+    event_loop_arm_timer(g_session.tick_fd, tick_ms, tick_ms);
+    event_loop_arm_timer(g_session.stats_fd, STATS_INTERVAL_MS, STATS_INTERVAL_MS);
+    
+    // Main loop
+    if (g_running) {
+        event_loop_run();
+    }
+    
     // Cleanup
-    serial_close(serial_fd);
+    log_stats();
+    serial_disconnect();
+    hotplug_cleanup();
+    metrics_close(g_session.metrics_fd, g_config.metrics_socket);
+    event_loop_cleanup();
     LOG_MESSAGE_INFO("Main loop completed");
 }
 
@@ -214,13 +808,39 @@ int main(int argc, char *argv[]) {
     // Daemonize if not in foreground mode
     daemon_daemonize();
     
-    // Set up signal handlers
-    daemon_setup_signals();
+    // Hand log I/O to the writer thread; the forked child is the one that keeps it
+    logger_start();
+    
+    // Block signals before any thread starts; the event loop receives them via signalfd
+    sigset_t signals;
+    daemon_setup_signals(&signals);
+    
+    // Open native temperature sensors
+    if (temperature_init() != 0) {
+        LOG_MESSAGE_ERR("Failed to initialize temperature sensors");
+        daemon_cleanup();
+        return EXIT_FAILURE;
+    }
+    
+    // Open CPU load counters (optional, the LOAD field is omitted without them)
+    load_init();
+    
+    // Start background sensor sampling
+    if (sampler_start() != 0) {
+        LOG_MESSAGE_ERR("Failed to start temperature sampler");
+        load_cleanup();
+        temperature_cleanup();
+        daemon_cleanup();
+        return EXIT_FAILURE;
+    }
     
     // Run main daemon loop
-    run_main_loop();
+    run_main_loop(&signals);
     
     // Cleanup
+    sampler_stop();
+    load_cleanup();
+    temperature_cleanup();
     daemon_cleanup();
     
     LOG_MESSAGE_INFO("Fan temperature daemon stopped");
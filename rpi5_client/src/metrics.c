@@ -0,0 +1,187 @@
+/**
+ * Metrics module for Fan Temperature Daemon
+ * Registry of counters and gauges, exported in the Prometheus text format
+ * through a Unix socket and a node_exporter textfile
+ */
+
+#include "metrics.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define METRICS_BUFFER_SIZE 8192
+#define METRICS_SOCKET_MODE 0660     // Owner and group only; the daemon runs with umask 0
+
+// Exported name, help text and type of each metric
+typedef struct {
+    const char *name;
+    const char *help;
+    int gauge;
+    int scale;              // Stored value per exported unit
+} metric_info_t;
+
+static const metric_info_t g_info[METRIC_COUNT] = {
+    [METRIC_POLLS] = {"fan_temp_polls_total", "POLL commands answered", 0, 1},
+    [METRIC_POLLS_COALESCED] = {"fan_temp_polls_coalesced_total", "Duplicate POLL commands folded into one response", 0, 1},
+    [METRIC_UNKNOWN_COMMANDS] = {"fan_temp_unknown_commands_total", "Unrecognized commands received", 0, 1},
+    [METRIC_PUSH_UPDATES] = {"fan_temp_push_updates_total", "Push updates sent", 0, 1},
+    [METRIC_PUSH_REPEATS] = {"fan_temp_push_repeats_total", "Push updates repeated until acknowledged", 0, 1},
+    [METRIC_BYTES_RECEIVED] = {"fan_temp_serial_received_bytes_total", "Bytes read from the serial port", 0, 1},
+    [METRIC_BYTES_SENT] = {"fan_temp_serial_sent_bytes_total", "Bytes written to the serial port", 0, 1},
+    [METRIC_SERIAL_ERRORS] = {"fan_temp_serial_errors_total", "Failed serial reads and hangups", 0, 1},
+    [METRIC_SERIAL_TIMEOUTS] = {"fan_temp_serial_timeouts_total", "Read timeouts without any data", 0, 1},
+    [METRIC_RECONNECTS] = {"fan_temp_serial_reconnects_total", "Serial port reconnections", 0, 1},
+    [METRIC_BAUD_FALLBACKS] = {"fan_temp_baud_fallbacks_total", "Returns to the configured baud rate after silence", 0, 1},
+    [METRIC_SENSOR_REFRESHES] = {"fan_temp_sensor_refreshes_total", "Sensor readings taken", 0, 1},
+    [METRIC_SENSOR_ERRORS] = {"fan_temp_sensor_errors_total", "Failed temperature readings", 0, 1},
+    [METRIC_LOG_DROPS] = {"fan_temp_log_dropped_total", "Log records dropped while the log writer was behind", 0, 1},
+    [METRIC_CONNECTED] = {"fan_temp_serial_connected", "Serial port open", 1, 1},
+    [METRIC_BAUD_RATE] = {"fan_temp_serial_baud_rate", "Baud rate currently applied", 1, 1},
+    [METRIC_CONSECUTIVE_ERRORS] = {"fan_temp_serial_consecutive_errors", "Serial errors since the last successful read", 1, 1},
+    [METRIC_CONSECUTIVE_TIMEOUTS] = {"fan_temp_serial_consecutive_timeouts", "Read timeouts since the last data", 1, 1},
+    [METRIC_SUCCESSFUL_EXCHANGES] = {"fan_temp_serial_successful_exchanges", "Recent answered POLLs (wraps at 10)", 1, 1},
+    [METRIC_PUSH_ACTIVE] = {"fan_temp_push_active", "Push mode enabled by the controller", 1, 1},
+    [METRIC_CPU_MILLIDEGREES] = {"fan_temp_cpu_celsius", "Latest CPU temperature", 1, 1000},
+    [METRIC_NVME_MILLIDEGREES] = {"fan_temp_nvme_celsius", "Latest NVME temperature", 1, 1000},
+};
+
+_Atomic int64_t g_metrics[METRIC_COUNT];
+
+/**
+ * Format every metric in the Prometheus text format
+ * Returns the length written, truncated to fit the buffer
+ */
+size_t metrics_format(char *buffer, size_t size) {
+    size_t len = 0;
+    
+    for (int id = 0; id < METRIC_COUNT && len < size; id++) {
+        const metric_info_t *info = &g_info[id];
+        int64_t value = metrics_get((metric_id_t)id);
+        int written;
+        
+        if (info->scale > 1) {
+            written = snprintf(buffer + len, size - len, "# HELP %s %s\n# TYPE %s %s\n%s %.3f\n",
+                               info->name, info->help, info->name, info->gauge ? "gauge" : "counter",
+                               info->name, (double)value / info->scale);
+        } else {
+            written = snprintf(buffer + len, size - len, "# HELP %s %s\n# TYPE %s %s\n%s %lld\n",
+                               info->name, info->help, info->name, info->gauge ? "gauge" : "counter",
+                               info->name, (long long)value);
+        }
+        if (written < 0) {
+            break;
+        }
+        len += (size_t)written;
+    }
+    
+    return len < size ? len : size - 1;
+}
+
+/**
+ * Create the non-blocking Unix socket that serves the metrics, replacing a stale one
+ * Any other file at path is left alone and makes this fail
+ * Returns the listening socket, or -1 on error
+ */
+int metrics_listen(const char *path) {
+    struct sockaddr_un addr;
+    struct stat st;
+    
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        LOG_MESSAGE_ERR("Metrics socket path too long: %s", path);
+        return -1;
+    }
+    
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            LOG_MESSAGE_ERR("Metrics socket path %s exists and is not a socket", path);
+            return -1;
+        }
+        unlink(path);
+    }
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_MESSAGE_ERR("Failed to create metrics socket: %s", strerror(errno));
+        return -1;
+    }
+    
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    
+    // Restrict the socket before listen(), so other users can never connect
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || chmod(path, METRICS_SOCKET_MODE) != 0 ||
+        listen(fd, 4) != 0) {
+        LOG_MESSAGE_ERR("Failed to listen on metrics socket %s: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    
+    LOG_MESSAGE_INFO("Serving metrics on %s", path);
+    return fd;
+}
+
+/**
+ * Answer every pending connection with the current metrics, then close it
+ */
+void metrics_serve(int listen_fd) {
+    char buffer[METRICS_BUFFER_SIZE];
+    size_t len = 0;
+    int client;
+    
+    while ((client = accept(listen_fd, NULL, NULL)) >= 0) {
+        if (len == 0) {
+            len = metrics_format(buffer, sizeof(buffer));
+        }
+        
+        // Fits the socket buffer; a client that is not reading just gets less
+        if (send(client, buffer, len, MSG_NOSIGNAL) < 0) {
+            LOG_MESSAGE_WARNING("Failed to send metrics: %s", strerror(errno));
+        }
+        close(client);
+    }
+}
+
+/**
+ * Rewrite the textfile atomically: write a temporary file beside it and rename it over
+ * node_exporter only collects *.prom files, so it never sees the temporary one
+ */
+int metrics_write_textfile(const char *path) {
+    char buffer[METRICS_BUFFER_SIZE];
+    char temp_path[4096];
+    
+    if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path)) {
+        return -1;
+    }
+    
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_MESSAGE_WARNING("Failed to write metrics textfile %s: %s", temp_path, strerror(errno));
+        return -1;
+    }
+    
+    size_t len = metrics_format(buffer, sizeof(buffer));
+    ssize_t written = write(fd, buffer, len);
+    if (close(fd) != 0 || written != (ssize_t)len || rename(temp_path, path) != 0) {
+        LOG_MESSAGE_WARNING("Failed to write metrics textfile %s: %s", path, strerror(errno));
+        unlink(temp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Close the metrics socket and remove its path
+ */
+void metrics_close(int listen_fd, const char *path) {
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(path);
+    }
+}
@@ -0,0 +1,176 @@
+/**
+ * Response encoding module for Fan Temperature Daemon
+ * Keeps the POLL response encoded as fixed-point text and re-encodes it only
+ * when a sampled value changes, so answering a POLL costs one small integer
+ * conversion for the sample age
+ */
+
+#include "response.h"
+#include <string.h>
+
+#define PUT_LITERAL(out, literal) (memcpy((out), (literal), sizeof(literal) - 1), sizeof(literal) - 1)
+
+/**
+ * Convert to hundredths, rounding to nearest and bounding the magnitude
+ */
+static long to_centi(float value, long limit) {
+    double centi = (double)value * 100.0;   // Exact for floats: matches "%.2f" except on exact ties
+    
+    if (!(centi < (double)limit)) {
+        return centi > 0 ? limit : 0;     // Above the limit, or NaN
+    } else if (centi < -(double)limit) {
+        return -limit;
+    }
+    return (long)(centi >= 0 ? centi + 0.5 : centi - 0.5);
+}
+
+/**
+ * Write an unsigned decimal integer, returning the number of characters
+ */
+static size_t put_uint(char *out, unsigned long value) {
+    char digits[20];
+    size_t count = 0;
+    
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    
+    for (size_t i = 0; i < count; i++) {
+        out[i] = digits[count - 1 - i];
+    }
+    return count;
+}
+
+/**
+ * Write hundredths as a decimal with two fraction digits, like "%.2f"
+ */
+static size_t put_centi(char *out, long centi) {
+    size_t len = 0;
+    
+    if (centi < 0) {
+        out[len++] = '-';
+        centi = -centi;
+    }
+    len += put_uint(out + len, (unsigned long)(centi / 100));
+    out[len++] = '.';
+    out[len++] = (char)('0' + (centi / 10) % 10);
+    out[len++] = (char)('0' + centi % 10);
+    return len;
+}
+
+/**
+ * Start with no encoded response
+ */
+void response_init(response_t *response) {
+    memset(response, 0, sizeof(*response));
+    response->iov[0].iov_base = response->head;
+    response->iov[1].iov_base = response->age;
+    response->iov[2].iov_base = response->tail;
+}
+
+/**
+ * Re-encode the cached response if the snapshot changes any reported value
+ * Returns 1 if the response was re-encoded, 0 if the cached bytes still apply
+ */
+int response_update(response_t *response, const temperature_snapshot_t *snapshot, int with_trend) {
+    long cpu = to_centi(snapshot->cpu_temp, RESPONSE_MAX_TEMP_CENTI);
+    long nvme = to_centi(snapshot->nvme_temp, RESPONSE_MAX_TEMP_CENTI);
+    long cpu_slope = with_trend ? to_centi(snapshot->cpu_slope, RESPONSE_MAX_SLOPE_CENTI) : 0;
+    long nvme_slope = with_trend ? to_centi(snapshot->nvme_slope, RESPONSE_MAX_SLOPE_CENTI) : 0;
+    long load = snapshot->cpu_load >= 0 ? (long)(snapshot->cpu_load + 0.5f) : -1;
+    
+    if (response->valid && response->with_trend == with_trend &&
+        response->cpu_centi == cpu && response->nvme_centi == nvme &&
+        response->cpu_slope_centi == cpu_slope && response->nvme_slope_centi == nvme_slope &&
+        response->load_pct == load) {
+        return 0;
+    }
+    
+    char *out = response->head;
+    out += PUT_LITERAL(out, "CPU:");
+    out += put_centi(out, cpu);
+    out += PUT_LITERAL(out, "|NVME:");
+    out += put_centi(out, nvme);
+    out += PUT_LITERAL(out, "|AGE:");
+    response->iov[0].iov_len = (size_t)(out - response->head);
+    
+    out = response->tail;
+    if (with_trend) {
+        out += PUT_LITERAL(out, "|DCPU:");
+        out += put_centi(out, cpu_slope);
+        out += PUT_LITERAL(out, "|DNVME:");
+        out += put_centi(out, nvme_slope);
+    }
+    if (load >= 0) {
+        out += PUT_LITERAL(out, "|LOAD:");
+        out += put_uint(out, (unsigned long)load);
+    }
+    *out++ = '\n';
+    response->iov[2].iov_len = (size_t)(out - response->tail);
+    
+    response->valid = 1;
+    response->with_trend = with_trend;
+    response->cpu_centi = cpu;
+    response->nvme_centi = nvme;
+    response->cpu_slope_centi = cpu_slope;
+    response->nvme_slope_centi = nvme_slope;
+    response->load_pct = load;
+    response->encodes++;
+    return 1;
+}
+
+/**
+ * Bound hundredths to the int16 range of the binary format
+ */
+static int16_t to_wire_centi(long centi) {
+    if (centi > WIRE_CENTI_MAX) {
+        return WIRE_CENTI_MAX;
+    } else if (centi < -WIRE_CENTI_MAX) {
+        return -WIRE_CENTI_MAX;
+    }
+    return (int16_t)centi;
+}
+
+/**
+ * Fill in the sample age for this POLL
+ * Returns the total response length; the response is in iov[0..RESPONSE_IOV_COUNT)
+ */
+size_t response_set_age(response_t *response, long age_ms) {
+    if (age_ms < 0) {
+        age_ms = 0;
+    } else if (age_ms > RESPONSE_MAX_AGE_MS) {
+        age_ms = RESPONSE_MAX_AGE_MS;
+    }
+    
+    response->iov[1].iov_len = put_uint(response->age, (unsigned long)age_ms);
+    response->length = response->iov[0].iov_len + response->iov[1].iov_len + response->iov[2].iov_len;
+    return response->length;
+}
+
+/**
+ * Encode the values of the last update and this POLL's sample age as a binary frame
+ * Returns the frame length; the frame, delimiter included, is in response->frame
+ */
+size_t response_encode_frame(response_t *response, long age_ms) {
+    wire_temperatures_t values;
+    
+    values.flags = 0;
+    values.cpu_centi = to_wire_centi(response->cpu_centi);
+    values.nvme_centi = to_wire_centi(response->nvme_centi);
+    values.age_ms = (uint16_t)(age_ms < 0 ? 0 : age_ms > UINT16_MAX ? UINT16_MAX : age_ms);
+    values.cpu_slope_centi = to_wire_centi(response->cpu_slope_centi);
+    values.nvme_slope_centi = to_wire_centi(response->nvme_slope_centi);
+    values.load_pct = 0;
+    
+    if (response->with_trend) {
+        values.flags |= WIRE_FLAG_TREND;
+    }
+    if (response->load_pct >= 0) {
+        values.flags |= WIRE_FLAG_LOAD;
+        values.load_pct = (uint8_t)(response->load_pct > 100 ? 100 : response->load_pct);
+    }
+    
+    response->frame_length = wire_encode_temperatures(&values, response->frame);
+    return response->frame_length;
+}
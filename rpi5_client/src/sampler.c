@@ -0,0 +1,339 @@
+/**
+ * Sampler module for Fan Temperature Daemon
+ * Refreshes sensor readings on a background thread and publishes them
+ * through a seqlock so the serial path never waits for a sensor
+ */
+
+#include "sampler.h"
+#include "temperature.h"
+#include "trend.h"
+#include "load.h"
+#include "config.h"
+#include "logger.h"
+#include "utils.h"
+#include "metrics.h"
+#include <stdatomic.h>
+#include <pthread.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#define STATS_LOG_INTERVAL_NS (300LL * 1000000000LL)  // Stats every 5 minutes
+
+// Cached sensor value with TTL and refresh statistics
+typedef struct {
+    const char *name;
+    int (*read)(const char *cmd, float *value);   // 0 on success, -1 with a fallback value
+    char **cmd;
+    const temp_source_t *source;
+    const int *ttl_ms;
+    int has_trend;              // Slope is reported for this sensor
+    float value;
+    int64_t refreshed_ns;
+    int64_t good_ns;            // Last successful read, the value is older than this when the read failed
+    int failed;
+    unsigned long hits;
+    unsigned long misses;
+    int64_t refresh_total_ns;
+    int64_t refresh_max_ns;
+    trend_t trend;
+} sensor_cache_t;
+
+/**
+ * Read CPU utilization (sensor table adapter, takes no command)
+ */
+static int read_cpu_load(const char *cmd, float *value) {
+    (void)cmd;
+    *value = load_get_utilization();
+    return *value < 0 ? -1 : 0;
+}
+
+static sensor_cache_t g_sensors[] = {
+    {"CPU", temperature_get_cpu, &g_config.cpu_temp_cmd, &g_config.cpu_source, &g_config.cpu_interval_ms, 1, 0, 0, 0, 0, 0, 0, 0, 0, {{0}, {0}, 0, 0, 0}},
+    {"NVME", temperature_get_nvme, &g_config.nvme_temp_cmd, &g_config.nvme_source, &g_config.nvme_interval_ms, 1, 0, 0, 0, 0, 0, 0, 0, 0, {{0}, {0}, 0, 0, 0}},
+    {"LOAD", read_cpu_load, NULL, NULL, &g_config.cpu_interval_ms, 0, 0, 0, 0, 0, 0, 0, 0, 0, {{0}, {0}, 0, 0, 0}},
+};
+#define SENSOR_CPU  0
+#define SENSOR_NVME 1
+#define SENSOR_LOAD 2
+#define NUM_SENSORS (sizeof(g_sensors) / sizeof(g_sensors[0]))
+
+// Seqlock protected snapshot: odd sequence means a write is in progress
+static atomic_uint g_seq = 0;
+static _Atomic float g_cpu_temp;
+static _Atomic float g_nvme_temp;
+static _Atomic float g_cpu_slope;
+static _Atomic float g_nvme_slope;
+static _Atomic float g_cpu_load;
+static _Atomic int64_t g_timestamp_ns;
+
+static pthread_t g_thread;
+static pthread_mutex_t g_stop_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_stop_cond;
+static int g_stop_requested = 0;
+static int g_thread_running = 0;
+static int g_notify_fd = -1;        // Counts published samples for the event loop
+
+/**
+ * Publish a new sample (single writer: the sampler thread)
+ */
+static void publish_sample(float cpu_temp, float nvme_temp, float cpu_slope, float nvme_slope,
+                           float cpu_load, int64_t timestamp_ns) {
+    unsigned int seq = atomic_load_explicit(&g_seq, memory_order_relaxed);
+    
+    atomic_store_explicit(&g_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    atomic_store_explicit(&g_cpu_temp, cpu_temp, memory_order_relaxed);
+    atomic_store_explicit(&g_nvme_temp, nvme_temp, memory_order_relaxed);
+    atomic_store_explicit(&g_cpu_slope, cpu_slope, memory_order_relaxed);
+    atomic_store_explicit(&g_nvme_slope, nvme_slope, memory_order_relaxed);
+    atomic_store_explicit(&g_cpu_load, cpu_load, memory_order_relaxed);
+    atomic_store_explicit(&g_timestamp_ns, timestamp_ns, memory_order_relaxed);
+    
+    atomic_store_explicit(&g_seq, seq + 2, memory_order_release);
+    
+    if (g_notify_fd >= 0) {
+        eventfd_write(g_notify_fd, 1);
+    }
+}
+
+/**
+ * Get sensor value, refreshing it only when the cached value has expired
+ */
+static float sensor_cache_get(sensor_cache_t *sensor, int64_t now_ns) {
+    int64_t ttl_ns = (int64_t)*sensor->ttl_ms * 1000000LL;
+    
+    // A coprocess pushes readings on its own schedule; draining its pipe is a single read()
+    if (sensor->source != NULL && *sensor->source == TEMP_SOURCE_COPROC) {
+        ttl_ns = 0;
+    }
+    
+    if (sensor->refreshed_ns != 0 && now_ns - sensor->refreshed_ns < ttl_ns) {
+        sensor->hits++;
+        return sensor->value;
+    }
+    
+    sensor->misses++;
+    metrics_inc(METRIC_SENSOR_REFRESHES);
+    // Last good and default values would flatten the slope, only fresh readings go into the trend
+    sensor->failed = sensor->read(sensor->cmd != NULL ? *sensor->cmd : NULL, &sensor->value) != 0;
+    if (!sensor->failed) {
+        sensor->good_ns = now_ns;
+        if (sensor->has_trend) {
+            trend_add(&sensor->trend, now_ns, sensor->value);
+        }
+    }
+    
+    int64_t cost_ns = utils_monotonic_ns() - now_ns;
+    sensor->refresh_total_ns += cost_ns;
+    if (cost_ns > sensor->refresh_max_ns) {
+        sensor->refresh_max_ns = cost_ns;
+    }
+    
+    // Expire relative to the start of the refresh so the period stays stable
+    sensor->refreshed_ns = now_ns;
+    return sensor->value;
+}
+
+/**
+ * Refresh expired sensors and publish the result
+ * A temperature whose read failed dates the sample back to its last good reading
+ */
+static void take_sample(void) {
+    int64_t now_ns = utils_monotonic_ns();
+    float cpu_temp = sensor_cache_get(&g_sensors[SENSOR_CPU], now_ns);
+    float nvme_temp = sensor_cache_get(&g_sensors[SENSOR_NVME], now_ns);
+    float cpu_load = sensor_cache_get(&g_sensors[SENSOR_LOAD], now_ns);
+    int64_t timestamp_ns = utils_monotonic_ns();
+    
+    for (size_t i = SENSOR_CPU; i <= SENSOR_NVME; i++) {
+        if (g_sensors[i].failed && g_sensors[i].good_ns < timestamp_ns) {
+            timestamp_ns = g_sensors[i].good_ns;
+        }
+    }
+    
+    publish_sample(cpu_temp, nvme_temp,
+                   trend_slope(&g_sensors[SENSOR_CPU].trend), trend_slope(&g_sensors[SENSOR_NVME].trend),
+                   cpu_load, timestamp_ns);
+}
+
+/**
+ * Time at which the next cached value expires
+ */
+static int64_t next_refresh_ns(void) {
+    int64_t next = INT64_MAX;
+    
+    for (size_t i = 0; i < NUM_SENSORS; i++) {
+        int64_t due = g_sensors[i].refreshed_ns + (int64_t)*g_sensors[i].ttl_ms * 1000000LL;
+        if (due < next) {
+            next = due;
+        }
+    }
+    
+    return next;
+}
+
+/**
+ * Log cache hit/miss counters and refresh cost for each sensor
+ */
+static void log_stats(void) {
+    for (size_t i = 0; i < NUM_SENSORS; i++) {
+        const sensor_cache_t *sensor = &g_sensors[i];
+        unsigned long lookups = sensor->hits + sensor->misses;
+        
+        LOG_MESSAGE_INFO("%s sensor cache: %lu hits, %lu misses (%.1f%% hit rate), refresh avg %.3fms max %.3fms",
+                         sensor->name, sensor->hits, sensor->misses,
+                         lookups ? 100.0 * sensor->hits / lookups : 0.0,
+                         sensor->misses ? sensor->refresh_total_ns / 1e6 / sensor->misses : 0.0,
+                         sensor->refresh_max_ns / 1e6);
+    }
+}
+
+/**
+ * Sampler thread main function
+ */
+static void *sampler_thread(void *arg) {
+    (void)arg;
+    struct timespec deadline;
+    int64_t next_stats_ns = utils_monotonic_ns() + STATS_LOG_INTERVAL_NS;
+    
+    pthread_mutex_lock(&g_stop_mutex);
+    while (!g_stop_requested) {
+        // Sleep until the next cached value expires
+        int64_t due_ns = next_refresh_ns();
+        deadline.tv_sec = due_ns / 1000000000LL;
+        deadline.tv_nsec = due_ns % 1000000000LL;
+        
+        while (!g_stop_requested &&
+               pthread_cond_timedwait(&g_stop_cond, &g_stop_mutex, &deadline) != ETIMEDOUT) {
+            // Spurious wakeup or stop request - re-check
+        }
+        if (g_stop_requested) {
+            break;
+        }
+        
+        pthread_mutex_unlock(&g_stop_mutex);
+        take_sample();
+        
+        if (utils_monotonic_ns() >= next_stats_ns) {
+            if (g_config.verbose) {
+                log_stats();
+            }
+            temperature_log_command_stats();
+            next_stats_ns += STATS_LOG_INTERVAL_NS;
+        }
+        pthread_mutex_lock(&g_stop_mutex);
+    }
+    pthread_mutex_unlock(&g_stop_mutex);
+    
+    return NULL;
+}
+
+/**
+ * Take the first sample synchronously and start the sampler thread
+ */
+int sampler_start(void) {
+    pthread_condattr_t attr;
+    
+    for (size_t i = 0; i < NUM_SENSORS; i++) {
+        trend_init(&g_sensors[i].trend, g_config.trend_samples);
+    }
+    
+    g_notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (g_notify_fd < 0) {
+        LOG_MESSAGE_WARNING("Failed to create sample notification: %s", strerror(errno));
+    }
+    
+    // Ensure a valid snapshot exists before the first POLL can arrive
+    take_sample();
+    
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_stop_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    
+    // Keep every signal off the sampler thread; the event loop reads them from a signalfd
+    sigset_t block_all, previous;
+    sigfillset(&block_all);
+    pthread_sigmask(SIG_SETMASK, &block_all, &previous);
+    
+    g_stop_requested = 0;
+    int result = pthread_create(&g_thread, NULL, sampler_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (result != 0) {
+        LOG_MESSAGE_ERR("Failed to start sampler thread: %s", strerror(result));
+        pthread_cond_destroy(&g_stop_cond);
+        return -1;
+    }
+    g_thread_running = 1;
+    
+    LOG_MESSAGE_INFO("Temperature sampler started (CPU every %dms, NVME every %dms)",
+                     g_config.cpu_interval_ms, g_config.nvme_interval_ms);
+    return 0;
+}
+
+/**
+ * Stop the sampler thread and wait for it to exit
+ */
+void sampler_stop(void) {
+    if (!g_thread_running) {
+        return;
+    }
+    
+    pthread_mutex_lock(&g_stop_mutex);
+    g_stop_requested = 1;
+    pthread_cond_signal(&g_stop_cond);
+    pthread_mutex_unlock(&g_stop_mutex);
+    
+    pthread_join(g_thread, NULL);
+    pthread_cond_destroy(&g_stop_cond);
+    g_thread_running = 0;
+    
+    log_stats();
+    temperature_log_command_stats();
+    
+    if (g_notify_fd >= 0) {
+        close(g_notify_fd);
+        g_notify_fd = -1;
+    }
+}
+
+/**
+ * File descriptor that becomes readable when a new sample is published, -1 if unavailable
+ * Read it with eventfd_read() to wait for the next sample
+ */
+int sampler_notify_fd(void) {
+    return g_notify_fd;
+}
+
+/**
+ * Get a consistent copy of the latest sample (lock-free, never blocks the writer)
+ */
+void sampler_get_snapshot(temperature_snapshot_t *snapshot) {
+    unsigned int seq_before, seq_after;
+    
+    do {
+        seq_before = atomic_load_explicit(&g_seq, memory_order_acquire);
+        
+        snapshot->cpu_temp = atomic_load_explicit(&g_cpu_temp, memory_order_relaxed);
+        snapshot->nvme_temp = atomic_load_explicit(&g_nvme_temp, memory_order_relaxed);
+        snapshot->cpu_slope = atomic_load_explicit(&g_cpu_slope, memory_order_relaxed);
+        snapshot->nvme_slope = atomic_load_explicit(&g_nvme_slope, memory_order_relaxed);
+        snapshot->cpu_load = atomic_load_explicit(&g_cpu_load, memory_order_relaxed);
+        snapshot->timestamp_ns = atomic_load_explicit(&g_timestamp_ns, memory_order_relaxed);
+        
+        atomic_thread_fence(memory_order_acquire);
+        seq_after = atomic_load_explicit(&g_seq, memory_order_relaxed);
+    } while ((seq_before & 1) || seq_before != seq_after);
+}
+
+/**
+ * Age of a snapshot in milliseconds
+ */
+long sampler_snapshot_age_ms(const temperature_snapshot_t *snapshot) {
+    return (long)((utils_monotonic_ns() - snapshot->timestamp_ns) / 1000000);
+}
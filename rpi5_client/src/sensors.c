@@ -0,0 +1,451 @@
+/**
+ * Sensor index module for Fan Temperature Daemon
+ * Discovers native temperature sensors in sysfs, keeps them open and
+ * aggregates each group into one reported temperature
+ */
+
+#include "sensors.h"
+#include "temperature.h"
+#include "logger.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <linux/nvme_ioctl.h>
+
+#define NVME_ADMIN_GET_LOG_PAGE 0x02
+#define NVME_LOG_SMART_HEALTH   0x02
+#define NVME_SMART_LOG_SIZE     512
+
+/**
+ * Read a short sysfs attribute into buffer (null-terminated, newline stripped)
+ */
+static int read_sysfs_attr(const char *path, char *buffer, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    
+    ssize_t len = read(fd, buffer, size - 1);
+    close(fd);
+    if (len <= 0) {
+        return -1;
+    }
+    
+    buffer[len] = '\0';
+    buffer[strcspn(buffer, "\n")] = '\0';
+    return 0;
+}
+
+/**
+ * Read a millidegree sensor file with pread() and convert to degrees
+ */
+static int read_millidegree_fd(int fd, float *temp) {
+    char buf[32];
+    
+    ssize_t len = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (len <= 0) {
+        return -1;
+    }
+    buf[len] = '\0';
+    
+    return temperature_parse_millidegrees(buf, temp);
+}
+
+/**
+ * Read the composite temperature from the NVME SMART/Health log page
+ */
+static int read_nvme_smart_log(int fd, float *temp) {
+    uint8_t log[NVME_SMART_LOG_SIZE];
+    struct nvme_admin_cmd cmd;
+    
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = NVME_ADMIN_GET_LOG_PAGE;
+    cmd.nsid = 0xffffffff;
+    cmd.addr = (uint64_t)(uintptr_t)log;
+    cmd.data_len = sizeof(log);
+    cmd.cdw10 = ((sizeof(log) / 4 - 1) << 16) | NVME_LOG_SMART_HEALTH;  // NUMDL | LID
+    
+    if (ioctl(fd, NVME_IOCTL_ADMIN_CMD, &cmd) < 0) {
+        return -1;
+    }
+    
+    // Bytes 1-2: composite temperature in Kelvin, little endian
+    unsigned int kelvin = log[1] | (log[2] << 8);
+    if (kelvin == 0) {
+        return -1;
+    }
+    
+    *temp = kelvin - 273.15f;
+    return 0;
+}
+
+/**
+ * Read one sensor from its open file
+ */
+static int read_sensor(const sensor_t *sensor, float *temp) {
+    if (sensor->kind == SENSOR_KIND_NVME_IOCTL) {
+        return read_nvme_smart_log(sensor->fd, temp);
+    }
+    
+    return read_millidegree_fd(sensor->fd, temp);
+}
+
+/**
+ * Look up the configured weight of a sensor label (FAN_TEMP_SENSOR_WEIGHTS)
+ * Sensors not listed have weight 1
+ */
+static float lookup_weight(const char *label) {
+    const char *entry = g_config.sensor_weights;
+    size_t label_len = strlen(label);
+    
+    while (entry != NULL && *entry != '\0') {
+        const char *colon = strchr(entry, ':');
+        if (colon == NULL) {
+            break;
+        }
+        
+        if ((size_t)(colon - entry) == label_len && strncmp(entry, label, label_len) == 0) {
+            return strtof(colon + 1, NULL);
+        }
+        
+        entry = strchr(colon, ',');
+        if (entry != NULL) {
+            entry++;
+        }
+    }
+    
+    return 1.0f;
+}
+
+/**
+ * Check whether name is one of the hwmon chips that report the CPU package
+ */
+static int is_cpu_hwmon(const char *name) {
+    static const char *cpu_chips[] = {"coretemp", "k10temp", "zenpower", NULL};
+    
+    for (int i = 0; cpu_chips[i] != NULL; i++) {
+        if (strcmp(name, cpu_chips[i]) == 0) {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * Add every hwmon chip for which match() accepts the chip name
+ * The sensor label is the name of the device the chip belongs to (e.g. nvme0)
+ */
+static void add_hwmon_chips(sensor_group_t *group, int (*match)(const char *name)) {
+    char hwmon_dir[256];
+    snprintf(hwmon_dir, sizeof(hwmon_dir), "%s/class/hwmon", g_config.sysfs_root);
+    
+    DIR *dir = opendir(hwmon_dir);
+    if (dir == NULL) {
+        return;
+    }
+    
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        char path[512];
+        char name[64];
+        
+        if (strncmp(entry->d_name, "hwmon", 5) != 0) {
+            continue;
+        }
+        
+        int len = snprintf(path, sizeof(path), "%s/%s/name", hwmon_dir, entry->d_name);
+        if (len >= (int)sizeof(path) || read_sysfs_attr(path, name, sizeof(name)) != 0 || !match(name)) {
+            continue;
+        }
+        
+        // Label by owning device when the link resolves, otherwise by chip directory
+        char link[256];
+        const char *label = entry->d_name;
+        ssize_t link_len = -1;
+        if (snprintf(path, sizeof(path), "%s/%s/device", hwmon_dir, entry->d_name) < (int)sizeof(path)) {
+            link_len = readlink(path, link, sizeof(link) - 1);
+        }
+        if (link_len > 0) {
+            link[link_len] = '\0';
+            const char *base = strrchr(link, '/');
+            label = base ? base + 1 : link;
+        }
+        
+        if (snprintf(path, sizeof(path), "%s/%s/temp1_input", hwmon_dir, entry->d_name) < (int)sizeof(path)) {
+            sensors_add(group, label, path, SENSOR_KIND_MILLIDEGREE);
+        }
+    }
+    closedir(dir);
+}
+
+/**
+ * Check whether name is the hwmon chip of an NVME controller
+ */
+static int is_nvme_hwmon(const char *name) {
+    return strcmp(name, "nvme") == 0;
+}
+
+/**
+ * Initialize an empty sensor group
+ */
+void sensors_group_init(sensor_group_t *group, const char *name, temp_aggregate_t aggregate, float max_valid) {
+    memset(group, 0, sizeof(*group));
+    group->name = name;
+    group->aggregate = aggregate;
+    group->max_valid = max_valid;
+}
+
+/**
+ * Open a sensor and add it to the group if it returns a valid reading
+ */
+int sensors_add(sensor_group_t *group, const char *label, const char *path, sensor_kind_t kind) {
+    float temp;
+    
+    if (group->count >= SENSORS_MAX_PER_GROUP) {
+        LOG_MESSAGE_WARNING("Too many %s sensors, ignoring %s", group->name, path);
+        return -1;
+    }
+    
+    sensor_t *sensor = &group->sensors[group->count];
+    snprintf(sensor->label, sizeof(sensor->label), "%s", label);
+    snprintf(sensor->path, sizeof(sensor->path), "%s", path);
+    sensor->kind = kind;
+    sensor->weight = lookup_weight(sensor->label);
+    
+    if (sensor->weight <= 0) {
+        LOG_MESSAGE_INFO("%s sensor %s (%s) excluded by weight", group->name, sensor->label, path);
+        return -1;
+    }
+    
+    sensor->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (sensor->fd < 0) {
+        return -1;
+    }
+    
+    if (read_sensor(sensor, &temp) != 0) {
+        LOG_MESSAGE_WARNING("%s sensor %s returned unreadable data", group->name, path);
+        close(sensor->fd);
+        sensor->fd = -1;
+        return -1;
+    }
+    
+    sensor->value = temp;
+    group->count++;
+    return 0;
+}
+
+/**
+ * Add a comma separated list of sensor files, labelled by their directory name
+ * Returns the number of sensors added
+ */
+int sensors_add_paths(sensor_group_t *group, const char *paths) {
+    int added = 0;
+    char *list = strdup(paths);
+    char *save = NULL;
+    
+    if (list == NULL) {
+        return 0;
+    }
+    
+    for (char *path = strtok_r(list, ",", &save); path != NULL; path = strtok_r(NULL, ",", &save)) {
+        char dir[256];
+        snprintf(dir, sizeof(dir), "%s", path);
+        
+        char *slash = strrchr(dir, '/');
+        if (slash != NULL) {
+            *slash = '\0';
+        }
+        slash = strrchr(dir, '/');
+        
+        if (sensors_add(group, slash ? slash + 1 : dir, path, SENSOR_KIND_MILLIDEGREE) == 0) {
+            added++;
+        }
+    }
+    
+    free(list);
+    return added;
+}
+
+/**
+ * Check whether a thermal zone type names a CPU/SoC sensor
+ */
+static int is_cpu_zone(const char *type) {
+    static const char *cpu_types[] = {"cpu-thermal", "cpu_thermal", "x86_pkg_temp", "soc_thermal", NULL};
+    
+    for (int i = 0; cpu_types[i] != NULL; i++) {
+        if (strcmp(type, cpu_types[i]) == 0) {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * Add every thermal zone typed as a CPU sensor, or the lowest numbered zone if none is
+ * Zones such as acpitz, pch or iwlwifi report other parts of the board
+ */
+static void add_cpu_thermal_zones(sensor_group_t *group) {
+    char thermal_dir[256];
+    snprintf(thermal_dir, sizeof(thermal_dir), "%s/class/thermal", g_config.sysfs_root);
+    
+    DIR *dir = opendir(thermal_dir);
+    if (dir == NULL) {
+        return;
+    }
+    
+    char fallback_path[512] = "";
+    char fallback_type[32] = "";
+    int fallback_zone = -1;
+    int cpu_zones = 0;
+    
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        char path[512];
+        char type[32];
+        
+        if (strncmp(entry->d_name, "thermal_zone", 12) != 0) {
+            continue;
+        }
+        
+        // Zones are labelled by type (e.g. cpu-thermal) so weights survive renumbering
+        int len = snprintf(path, sizeof(path), "%s/%s/type", thermal_dir, entry->d_name);
+        if (len >= (int)sizeof(path) || read_sysfs_attr(path, type, sizeof(type)) != 0) {
+            if (snprintf(type, sizeof(type), "%s", entry->d_name) >= (int)sizeof(type)) {
+                continue;
+            }
+        }
+        
+        if (snprintf(path, sizeof(path), "%s/%s/temp", thermal_dir, entry->d_name) >= (int)sizeof(path)) {
+            continue;
+        }
+        
+        if (is_cpu_zone(type)) {
+            sensors_add(group, type, path, SENSOR_KIND_MILLIDEGREE);
+            cpu_zones++;
+        } else {
+            int zone = atoi(entry->d_name + 12);
+            if (fallback_zone < 0 || zone < fallback_zone) {
+                fallback_zone = zone;
+                snprintf(fallback_path, sizeof(fallback_path), "%s", path);
+                snprintf(fallback_type, sizeof(fallback_type), "%s", type);
+            }
+        }
+    }
+    closedir(dir);
+    
+    if (cpu_zones == 0 && fallback_zone >= 0) {
+        sensors_add(group, fallback_type, fallback_path, SENSOR_KIND_MILLIDEGREE);
+    }
+}
+
+/**
+ * Discover CPU sensors: CPU package hwmon chips, or without one the CPU thermal zones
+ * coretemp and x86_pkg_temp report the same package, so only one of them is used
+ * Returns the number of sensors in the group
+ */
+int sensors_discover_cpu(sensor_group_t *group) {
+    add_hwmon_chips(group, is_cpu_hwmon);
+    
+    if (group->count == 0) {
+        add_cpu_thermal_zones(group);
+    }
+    
+    return group->count;
+}
+
+/**
+ * Discover NVME sensors: the hwmon chip of every controller
+ * Without hwmon support, the configured device is read with admin commands instead
+ * Returns the number of sensors in the group
+ */
+int sensors_discover_nvme(sensor_group_t *group) {
+    add_hwmon_chips(group, is_nvme_hwmon);
+    
+    if (group->count == 0) {
+        const char *name = strrchr(g_config.nvme_device, '/');
+        name = name ? name + 1 : g_config.nvme_device;
+        
+        sensors_add(group, name, g_config.nvme_device, SENSOR_KIND_NVME_IOCTL);
+    }
+    
+    return group->count;
+}
+
+/**
+ * Read all sensors of the group and aggregate them
+ * Returns 0 when at least one sensor produced a valid reading
+ */
+int sensors_read(sensor_group_t *group, float *temp) {
+    float result = 0;
+    float weight_sum = 0;
+    int valid = 0;
+    
+    for (int i = 0; i < group->count; i++) {
+        sensor_t *sensor = &group->sensors[i];
+        float value;
+        
+        if (read_sensor(sensor, &value) != 0 || value <= 0 || value >= group->max_valid) {
+            continue;  // Skip failed or implausible readings
+        }
+        sensor->value = value;
+        
+        if (group->aggregate == TEMP_AGGREGATE_MEAN) {
+            result += value * sensor->weight;
+            weight_sum += sensor->weight;
+        } else if (!valid || value > result) {
+            result = value;
+        }
+        valid++;
+    }
+    
+    if (!valid) {
+        return -1;
+    }
+    
+    *temp = group->aggregate == TEMP_AGGREGATE_MEAN ? result / weight_sum : result;
+    return 0;
+}
+
+/**
+ * Log the sensors of a group and the cost of reading all of them
+ */
+void sensors_log_group(sensor_group_t *group) {
+    float temp = 0;
+    
+    int64_t start_ns = utils_monotonic_ns();
+    int result = sensors_read(group, &temp);
+    int64_t duration_ns = utils_monotonic_ns() - start_ns;
+    
+    for (int i = 0; i < group->count; i++) {
+        const sensor_t *sensor = &group->sensors[i];
+        LOG_MESSAGE_INFO("%s sensor %s: %s (%.1fC, weight %.2f)", group->name, sensor->label,
+                         sensor->path, sensor->value, sensor->weight);
+    }
+    
+    LOG_MESSAGE_INFO("%s temperature source: %d native sensor%s, %s aggregate %.1fC, read in %.1fus",
+                     group->name, group->count, group->count == 1 ? "" : "s",
+                     group->aggregate == TEMP_AGGREGATE_MEAN ? "weighted mean" : "max",
+                     result == 0 ? temp : 0.0f, duration_ns / 1e3);
+}
+
+/**
+ * Close all sensors of a group
+ */
+void sensors_close(sensor_group_t *group) {
+    for (int i = 0; i < group->count; i++) {
+        if (group->sensors[i].fd >= 0) {
+            close(group->sensors[i].fd);
+            group->sensors[i].fd = -1;
+        }
+    }
+    group->count = 0;
+}
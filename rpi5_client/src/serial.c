@@ -7,6 +7,10 @@
 #include "logger.h"
 #include "config.h"
 #include "utils.h"
+#include "framer.h"
+#include "baud.h"
+#include "latency.h"
+#include "metrics.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,19 +18,18 @@
 #include <fcntl.h>
 #include <termios.h>
 #include <errno.h>
-#include <sys/select.h>
 #include <sys/ioctl.h>
+#include <linux/serial.h>
 
-// Static buffer for command reading
-static char g_read_buffer[512] = {0};
-static int g_buffer_pos = 0;
+// Line framer for command reading
+static framer_t g_framer;
+static int g_synchronized = 1;  // Cleared until the first line boundary after a resync
 
 /**
  * Reset the internal read buffer
  */
 void serial_reset_read_buffer(void) {
-    g_buffer_pos = 0;
-    memset(g_read_buffer, 0, sizeof(g_read_buffer));
+    framer_init(&g_framer);
     if (g_config.verbose) {
         LOG_MESSAGE_DEBUG("Serial read buffer reset");
     }
@@ -57,96 +60,85 @@ int serial_check_health(int fd) {
 }
 
 /**
- * Aggressively clear serial port and recover synchronization
+ * Recover synchronization without waiting
+ * Stale bytes are flushed and the stream is resynchronized as it arrives:
+ * the first line may be the tail of an interrupted transmission, so it is
+ * discarded unless it ends in a known command, and everything after it is live
  */
 void serial_recover_synchronization(int fd) {
-    char discard_buffer[256];
-    int attempts = 0;
-    
     if (g_config.verbose) {
         LOG_MESSAGE_DEBUG("Starting serial synchronization recovery");
     }
     
-    // Clear hardware buffers multiple times with longer delays
-    for (int i = 0; i < 5; i++) {
-        serial_clear_buffers(fd);
-        utils_sleep_ms(200);  // 200ms between flushes
+    serial_clear_buffers(fd);
+    
+    // Terminate any partial line the controller may still be assembling
+    if (write(fd, "\n", 1) < 0 && g_config.verbose) {
+        LOG_MESSAGE_DEBUG("Could not send sync newline: %s", strerror(errno));
     }
     
-    // Send a few dummy bytes to trigger any pending Arduino transmissions
-    const char *sync_chars = "\n\n\n";
-    write(fd, sync_chars, strlen(sync_chars));
-    fsync(fd);  // Force data to be sent
-    utils_sleep_ms(300);  // 300ms to let Arduino respond
+    serial_reset_read_buffer();
+    g_synchronized = 0;
+}
+
+/**
+ * Switch the port to another rate once pending output has been transmitted
+ * The applied rate is read back; bytes received at the old rate are discarded
+ */
+int serial_set_baud(int fd, int baud_rate) {
+    int actual_rate;
     
-    // Clear buffers again after sync attempt
-    serial_clear_buffers(fd);
-    utils_sleep_ms(100);  // 100ms
+    tcdrain(fd);
     
-    // Read and discard any remaining data with timeout
-    fd_set rdset;
-    struct timeval timeout;
+    if (baud_set(fd, baud_rate) != 0) {
+        LOG_MESSAGE_ERR("Error setting baud rate %d: %s", baud_rate, strerror(errno));
+        return -1;
+    }
     
-    while (attempts < 20) {  // Max 20 attempts
-        FD_ZERO(&rdset);
-        FD_SET(fd, &rdset);
-        
-        timeout.tv_sec = 0;
-        timeout.tv_usec = 100000;  // 100ms timeout
-        
-        int select_result = select(fd + 1, &rdset, NULL, NULL, &timeout);
-        
-        if (select_result > 0) {
-            int bytes_discarded = read(fd, discard_buffer, sizeof(discard_buffer) - 1);
-            if (bytes_discarded > 0) {
-                discard_buffer[bytes_discarded] = '\0';
-                if (g_config.verbose) {
-                    // Clean up the discarded data for logging
-                    char clean_discard[64];
-                    size_t j = 0;
-                    for (int i = 0; i < bytes_discarded && j < sizeof(clean_discard) - 3; i++) {
-                        if (discard_buffer[i] == '\n') {
-                            clean_discard[j++] = '\\';
-                            clean_discard[j++] = 'n';
-                        } else if (discard_buffer[i] == '\r') {
-                            clean_discard[j++] = '\\';
-                            clean_discard[j++] = 'r';
-                        } else if (discard_buffer[i] >= 32 && discard_buffer[i] <= 126) {
-                            clean_discard[j++] = discard_buffer[i];
-                        } else {
-                            clean_discard[j++] = '?';
-                        }
-                    }
-                    clean_discard[j] = '\0';
-                    LOG_MESSAGE_DEBUG("Discarded stale data: '%s' (%d bytes)", clean_discard, bytes_discarded);
-                }
-                attempts++;
-            } else {
-                break;  // No more data
-            }
-        } else {
-            break;  // Timeout or error - no more data
-        }
+    // Read back the rate the driver applied; a mismatch would look like a silent controller
+    if (baud_get(fd, &actual_rate) != 0) {
+        LOG_MESSAGE_ERR("Error reading back baud rate: %s", strerror(errno));
+        return -1;
     }
     
-    // Final aggressive cleanup sequence
-    serial_clear_buffers(fd);
-    utils_sleep_ms(100);  // 100ms
-    serial_clear_buffers(fd);
-    utils_sleep_ms(50);   // 50ms
+    long deviation = labs((long)actual_rate - baud_rate) * 100;
+    if (deviation > (long)baud_rate * BAUD_TOLERANCE) {
+        LOG_MESSAGE_ERR("Serial port runs at %d baud instead of %d", actual_rate, baud_rate);
+        return -1;
+    } else if (actual_rate != baud_rate) {
+        LOG_MESSAGE_WARNING("Serial port runs at %d baud, requested %d", actual_rate, baud_rate);
+    }
     
-    // Reset internal read buffer
+    tcflush(fd, TCIFLUSH);
     serial_reset_read_buffer();
+    return 0;
+}
+
+/**
+ * Ask the UART driver to push received bytes to the tty layer immediately
+ * instead of batching them; not every driver supports this
+ */
+static void set_low_latency(int fd) {
+    struct serial_struct serial;
     
-    if (g_config.verbose) {
-        LOG_MESSAGE_DEBUG("Serial synchronization recovery completed (%d cleanup attempts)", attempts);
+    if (ioctl(fd, TIOCGSERIAL, &serial) != 0) {
+        LOG_MESSAGE_WARNING("Low-latency mode not supported by the serial driver: %s", strerror(errno));
+        return;
+    }
+    
+    serial.flags |= ASYNC_LOW_LATENCY;
+    if (ioctl(fd, TIOCSSERIAL, &serial) != 0) {
+        LOG_MESSAGE_WARNING("Could not enable low-latency mode: %s", strerror(errno));
+        return;
     }
+    
+    LOG_MESSAGE_INFO("Serial driver low-latency mode enabled");
 }
 
 /**
  * Configure and open serial port
  */
-int serial_setup(const char *port, speed_t baud_rate) {
+int serial_setup(const char *port, int baud_rate) {
     int fd;
     struct termios tty;
     
@@ -156,17 +148,13 @@ int serial_setup(const char *port, speed_t baud_rate) {
     }
     
     // Open serial port with additional flags for reliability
-    fd = open(port, O_RDWR | O_NOCTTY | O_SYNC | O_NONBLOCK);
+    fd = open(port, O_RDWR | O_NOCTTY | O_NONBLOCK);
     if (fd < 0) {
         LOG_MESSAGE_ERR("Error opening serial port %s: %s", port, strerror(errno));
         return -1;
     }
     
-    // Remove non-blocking flag after opening (we'll use select() for timeouts)
-    int flags = fcntl(fd, F_GETFL);
-    if (flags != -1) {
-        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
-    }
+    // Keep the port non-blocking: it is read from the event loop when epoll reports data
     
     // Clear any existing data in buffers
     serial_clear_buffers(fd);
@@ -178,10 +166,6 @@ int serial_setup(const char *port, speed_t baud_rate) {
         return -1;
     }
     
-    // Set baud rate
-    cfsetospeed(&tty, baud_rate);
-    cfsetispeed(&tty, baud_rate);
-    
     // Configure for 8N1 (8 data bits, no parity, 1 stop bit)
     tty.c_cflag &= ~PARENB;        // Clear parity bit, disabling parity
     tty.c_cflag &= ~CSTOPB;        // Clear stop field, only one stop bit used
@@ -209,9 +193,11 @@ int serial_setup(const char *port, speed_t baud_rate) {
     tty.c_lflag &= ~(ICANON | ECHO | ECHOE | ECHOK | ECHONL | ISIG | IEXTEN);
     tty.c_lflag &= ~(XCASE);
     
-    // Set read behavior - non-blocking read with timeout
-    tty.c_cc[VMIN] = 0;   // Non-blocking read
-    tty.c_cc[VTIME] = 2;  // 0.2 second timeout
+    // The port is O_NONBLOCK, so reads never wait for VTIME. It still matters: with VMIN and
+    // VTIME both 0 a drained tty read() returns 0 instead of failing with EAGAIN, and
+    // serial_read_available() takes 0 for a hangup
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 2;
     
     // Set terminal attributes immediately
     if (tcsetattr(fd, TCSANOW, &tty) != 0) {
@@ -231,6 +217,16 @@ int serial_setup(const char *port, speed_t baud_rate) {
         }
     }
     
+    // Set baud rate through termios2, so that non-standard rates work too
+    if (serial_set_baud(fd, baud_rate) != 0) {
+        close(fd);
+        return -1;
+    }
+    
+    if (g_config.low_latency) {
+        set_low_latency(fd);
+    }
+    
     // Additional hardware-specific optimizations for Raspberry Pi
     int buffer_size = 8192;  // 8KB buffers
     if (ioctl(fd, TIOCOUTQ, &buffer_size) == 0) {
@@ -263,223 +259,246 @@ int serial_send_data(int fd, const char *data) {
         return -1;
     }
     
-    return write(fd, data, strlen(data));
+    ssize_t sent = write(fd, data, strlen(data));
+    if (sent > 0) {
+        metrics_add(METRIC_BYTES_SENT, sent);
+    }
+    return (int)sent;
 }
 
 /**
- * Read data from serial port (blocking with timeout)
+ * Write several buffers with a single writev()
+ * With FAN_TEMP_SERIAL_DRAIN set, waits until the bytes have left the UART
  */
-int serial_read_data(int fd, char *buffer, size_t size, int timeout_sec) {
-    if (fd < 0 || buffer == NULL || size == 0) {
+static ssize_t write_iov(int fd, const struct iovec *iov, int count) {
+    if (fd < 0 || iov == NULL) {
         return -1;
     }
     
-    fd_set rdset;
-    struct timeval timeout;
+    ssize_t sent;
+    do {
+        sent = writev(fd, iov, count);
+    } while (sent < 0 && errno == EINTR);
     
-    // Set up select() for blocking read with timeout
-    FD_ZERO(&rdset);
-    FD_SET(fd, &rdset);
+    if (sent >= 0 && g_config.serial_drain) {
+        tcdrain(fd);
+    }
+    if (sent > 0) {
+        metrics_add(METRIC_BYTES_SENT, sent);
+    }
+    return sent;
+}
+
+/**
+ * Send the response to a received command, recording its latency
+ */
+int serial_send_iov(int fd, const struct iovec *iov, int count) {
+    ssize_t sent = write_iov(fd, iov, count);
     
-    // Set timeout
-    timeout.tv_sec = timeout_sec;
-    timeout.tv_usec = 0;
+    if (sent >= 0) {
+        latency_complete();
+    }
     
-    // Wait for data with timeout
-    int select_result = select(fd + 1, &rdset, NULL, NULL, &timeout);
+    return (int)sent;
+}
+
+/**
+ * Send an update nothing asked for; it has no response latency
+ */
+int serial_push_iov(int fd, const struct iovec *iov, int count) {
+    return (int)write_iov(fd, iov, count);
+}
+
+/**
+ * Read all bytes currently available on the (non-blocking) serial port into the command buffer
+ * Returns the number of bytes read, 0 if none were pending, -1 on error or hangup
+ */
+int serial_read_available(int fd) {
+    char temp_buf[64];
+    int total = 0;
     
-    if (select_result > 0) {
-        // Data is available, read it
-        return read(fd, buffer, size - 1);
-    } else if (select_result == 0) {
-        // Timeout occurred
-        return 0;
-    } else {
-        // Error occurred
-        LOG_MESSAGE_ERR("Select error: %s", strerror(errno));
+    if (fd < 0) {
         return -1;
     }
+    
+    for (;;) {
+        int bytes_read = read(fd, temp_buf, sizeof(temp_buf) - 1);
+        
+        if (bytes_read == 0) {
+            errno = EIO;  // Hangup: the device went away
+            return -1;
+        } else if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return total;
+            }
+            return -1;
+        }
+        
+        temp_buf[bytes_read] = '\0';  // Null-terminate
+        total += bytes_read;
+        latency_mark(LATENCY_RECEIVED);
+        metrics_add(METRIC_BYTES_RECEIVED, bytes_read);
+        
+        if (g_config.verbose) {
+            // Log raw bytes in hex for debugging
+            char hex_log[256];
+            int hex_pos = 0;
+            hex_pos += snprintf(hex_log + hex_pos, sizeof(hex_log) - hex_pos, "Raw hex: ");
+            for (int i = 0; i < bytes_read && hex_pos < (int)sizeof(hex_log) - 4; i++) {
+                hex_pos += snprintf(hex_log + hex_pos, sizeof(hex_log) - hex_pos, "%02X ", (unsigned char)temp_buf[i]);
+            }
+            LOG_MESSAGE_DEBUG("%s", hex_log);
+            LOG_MESSAGE_DEBUG("Raw data received: %d bytes", bytes_read);
+        }
+        
+        // Add new data to the framer; on overflow the oldest bytes are dropped
+        framer_push(&g_framer, temp_buf, bytes_read);
+        
+        if (g_config.verbose) {
+            LOG_MESSAGE_DEBUG("Buffer now: %zu chars (%lu bytes dropped on overflow)",
+                              g_framer.len, g_framer.overflow_bytes);
+        }
+    }
 }
 
 /**
- * Read complete command from serial port (buffered with timeout)
- * This function accumulates data and extracts commands ending with \r\n or \n
+ * Extract the next complete command (ending with \r\n or \n) from the command buffer
+ * Returns the command length, or 0 if no complete command is buffered
  */
-int serial_read_complete_command(int fd, char *buffer, size_t size, int timeout_sec) {
-    char temp_buf[64];
-    
-    if (fd < 0 || buffer == NULL || size == 0) {
+int serial_next_command(char *buffer, size_t size) {
+    if (buffer == NULL || size == 0) {
         return -1;
     }
     
-    fd_set rdset;
-    struct timeval timeout;
+    int cmd_len = framer_next_line(&g_framer, buffer, size);
     
-    // Set up select() for blocking read with timeout
-    FD_ZERO(&rdset);
-    FD_SET(fd, &rdset);
+    if (cmd_len > 0 && g_config.verbose) {
+        LOG_MESSAGE_DEBUG("Found command: '%s' (len: %d)", buffer, cmd_len);
+    }
     
-    // Set timeout
-    timeout.tv_sec = timeout_sec;
-    timeout.tv_usec = 0;
+    return cmd_len;
+}
+
+/**
+ * Classify the first line after a resync, which may start mid-transmission
+ * Returns 1 if it carries a known command, with the noise before it removed
+ */
+static int recover_first_command(char *text, size_t len) {
+    static const char *const commands[] = {"POLL", "POLL:EXT", "POLL:BIN", "BAUD:", "ECHO:", "PROTO:", "PUSH:", "ACK"};
     
-    // Wait for data with timeout
-    int select_result = select(fd + 1, &rdset, NULL, NULL, &timeout);
+    // Trailing whitespace is not noise; bytes before the command may include NULs
+    while (len > 0 && (text[len - 1] == ' ' || text[len - 1] == '\t')) {
+        len--;
+    }
     
-    if (select_result > 0) {
-        // Data is available, read it
-        int bytes_read = read(fd, temp_buf, sizeof(temp_buf) - 1);
-        
-        if (bytes_read > 0) {
-            temp_buf[bytes_read] = '\0';  // Null-terminate
-            
-            if (g_config.verbose) {
-                // Log raw bytes in hex for debugging
-                char hex_log[256];
-                int hex_pos = 0;
-                hex_pos += snprintf(hex_log + hex_pos, sizeof(hex_log) - hex_pos, "Raw hex: ");
-                for (int i = 0; i < bytes_read && hex_pos < (int)sizeof(hex_log) - 4; i++) {
-                    hex_pos += snprintf(hex_log + hex_pos, sizeof(hex_log) - hex_pos, "%02X ", (unsigned char)temp_buf[i]);
-                }
-                LOG_MESSAGE_DEBUG("%s", hex_log);
-                LOG_MESSAGE_DEBUG("Raw data received: %d bytes", bytes_read);
-            }
+    // The last position where a known command starts ends the noise
+    for (size_t start = len; start-- > 0;) {
+        for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+            size_t command_len = strlen(commands[i]);
+            int prefix_only = commands[i][command_len - 1] == ':';
             
-            // Add new data to our buffer, handling overflow
-            for (int i = 0; i < bytes_read; i++) {
-                if (g_buffer_pos < (int)(sizeof(g_read_buffer) - 1)) {
-                    g_read_buffer[g_buffer_pos++] = temp_buf[i];
-                } else {
-                    // Buffer overflow - shift left and add new char
-                    memmove(g_read_buffer, g_read_buffer + 1, sizeof(g_read_buffer) - 2);
-                    g_read_buffer[sizeof(g_read_buffer) - 2] = temp_buf[i];
-                    g_buffer_pos = sizeof(g_read_buffer) - 1;
-                }
+            if (len - start < command_len || memcmp(text + start, commands[i], command_len) != 0 ||
+                (!prefix_only && len - start != command_len)) {
+                continue;
             }
-            g_read_buffer[g_buffer_pos] = '\0';
             
-            if (g_config.verbose) {
-                // Create a clean version of buffer for logging
-                char clean_log[128];
-                int clean_pos = 0;
-                for (int i = 0; i < g_buffer_pos && i < (int)sizeof(g_read_buffer) && clean_pos < 120; i++) {
-                    if (g_read_buffer[i] == '\n') {
-                        clean_log[clean_pos++] = '\\';
-                        clean_log[clean_pos++] = 'n';
-                    } else if (g_read_buffer[i] == '\r') {
-                        clean_log[clean_pos++] = '\\';
-                        clean_log[clean_pos++] = 'r';
-                    } else if (g_read_buffer[i] >= 32 && g_read_buffer[i] <= 126) {
-                        clean_log[clean_pos++] = g_read_buffer[i];
-                    } else {
-                        clean_log[clean_pos++] = '?';
-                    }
+            memmove(text, text + start, len - start);
+            text[len - start] = '\0';
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Collect up to SERIAL_BATCH_MAX buffered commands, cleaned and parsed
+ * Repeated POLLs of one format within the batch are coalesced: one response answers all of them
+ * Returns the number of commands in the batch, 0 when nothing complete is buffered
+ */
+int serial_next_batch(serial_batch_t *batch) {
+    int has_poll = 0;
+    int has_extended_poll = 0;
+    int has_binary_poll = 0;
+    
+    batch->count = 0;
+    batch->coalesced = 0;
+    
+    while (batch->count < SERIAL_BATCH_MAX) {
+        serial_command_t *command = &batch->commands[batch->count];
+        
+        int len = serial_next_command(command->text, sizeof(command->text));
+        if (len <= 0) {
+            break;
+        }
+        
+        if (!g_synchronized) {
+            // A line boundary has been seen: everything after it is live
+            g_synchronized = 1;
+            if (!recover_first_command(command->text, (size_t)len)) {
+                if (g_config.verbose) {
+                    LOG_MESSAGE_DEBUG("Discarded partial line while synchronizing: '%s'", command->text);
                 }
-                clean_log[clean_pos] = '\0';
-                LOG_MESSAGE_DEBUG("Buffer now: '%s' (%d chars)", clean_log, g_buffer_pos);
+                continue;
             }
-            
-            // Look for command ending with \r\n or \n
-            char *newline_pos = NULL;
-            int cmd_end = -1;
-            
-            // Search for \r\n first (Arduino format)
-            for (int i = 0; i < g_buffer_pos - 1; i++) {
-                if (g_read_buffer[i] == '\r' && g_read_buffer[i + 1] == '\n') {
-                    newline_pos = &g_read_buffer[i];
-                    cmd_end = i;
-                    break;
-                }
+        }
+        
+        utils_clean_buffer(command->text);
+        if (command->text[0] == '\0') {
+            continue;
+        }
+        
+        if (strcmp(command->text, "POLL") == 0) {
+            if (has_poll) {
+                batch->coalesced++;
+                continue;
             }
-            
-            // If no \r\n found, look for standalone \n
-            if (newline_pos == NULL) {
-                for (int i = 0; i < g_buffer_pos; i++) {
-                    if (g_read_buffer[i] == '\n') {
-                        newline_pos = &g_read_buffer[i];
-                        cmd_end = i;
-                        break;
-                    }
-                }
+            has_poll = 1;
+            command->type = SERIAL_COMMAND_POLL;
+        } else if (strcmp(command->text, "POLL:EXT") == 0) {
+            if (has_extended_poll) {
+                batch->coalesced++;
+                continue;
             }
-            
-            if (newline_pos != NULL && cmd_end >= 0) {
-                // Find the start of the command (skip any leading \n or \r\n)
-                int cmd_start = 0;
-                while (cmd_start < cmd_end && (g_read_buffer[cmd_start] == '\n' || g_read_buffer[cmd_start] == '\r')) {
-                    cmd_start++;
-                }
-                
-                int cmd_len = cmd_end - cmd_start;
-                
-                if (cmd_len > 0 && cmd_len < (int)size) {
-                    // Extract the command
-                    strncpy(buffer, g_read_buffer + cmd_start, cmd_len);
-                    buffer[cmd_len] = '\0';
-                    
-                    if (g_config.verbose) {
-                        LOG_MESSAGE_DEBUG("Found command: '%s' (len: %d)", buffer, cmd_len);
-                    }
-                    
-                    // Remove processed data including the line ending
-                    int chars_to_remove = cmd_end;
-                    // Skip the line ending characters
-                    if (chars_to_remove < g_buffer_pos - 1 && g_read_buffer[chars_to_remove] == '\r' && g_read_buffer[chars_to_remove + 1] == '\n') {
-                        chars_to_remove += 2; // Skip \r\n
-                    } else if (chars_to_remove < g_buffer_pos && g_read_buffer[chars_to_remove] == '\n') {
-                        chars_to_remove += 1; // Skip \n
-                    }
-                    
-                    if (chars_to_remove < g_buffer_pos) {
-                        memmove(g_read_buffer, g_read_buffer + chars_to_remove, g_buffer_pos - chars_to_remove);
-                        g_buffer_pos -= chars_to_remove;
-                        g_read_buffer[g_buffer_pos] = '\0';
-                    } else {
-                        g_buffer_pos = 0;
-                        g_read_buffer[0] = '\0';
-                    }
-                    
-                    return cmd_len;
-                } else {
-                    // Command too long or empty - skip this segment
-                    if (g_config.verbose) {
-                        LOG_MESSAGE_DEBUG("Skipping invalid command segment (len: %d)", cmd_len);
-                    }
-                    
-                    // Remove up to and including the line ending
-                    int chars_to_remove = cmd_end;
-                    if (chars_to_remove < g_buffer_pos - 1 && g_read_buffer[chars_to_remove] == '\r' && g_read_buffer[chars_to_remove + 1] == '\n') {
-                        chars_to_remove += 2;
-                    } else if (chars_to_remove < g_buffer_pos && g_read_buffer[chars_to_remove] == '\n') {
-                        chars_to_remove += 1;
-                    }
-                    
-                    if (chars_to_remove < g_buffer_pos) {
-                        memmove(g_read_buffer, g_read_buffer + chars_to_remove, g_buffer_pos - chars_to_remove);
-                        g_buffer_pos -= chars_to_remove;
-                        g_read_buffer[g_buffer_pos] = '\0';
-                    } else {
-                        g_buffer_pos = 0;
-                        g_read_buffer[0] = '\0';
-                    }
-                    
-                    // Try again with remaining buffer
-                    return serial_read_complete_command(fd, buffer, size, timeout_sec);
-                }
+            has_extended_poll = 1;
+            command->type = SERIAL_COMMAND_POLL_EXTENDED;
+        } else if (strcmp(command->text, "POLL:BIN") == 0) {
+            if (has_binary_poll) {
+                batch->coalesced++;
+                continue;
             }
-            
-            return 0;  // Need more data
+            has_binary_poll = 1;
+            command->type = SERIAL_COMMAND_POLL_BINARY;
+        } else if (strncmp(command->text, "BAUD:", 5) == 0) {
+            command->type = SERIAL_COMMAND_BAUD;
+        } else if (strncmp(command->text, "ECHO:", 5) == 0) {
+            command->type = SERIAL_COMMAND_ECHO;
+        } else if (strncmp(command->text, "PROTO:", 6) == 0) {
+            command->type = SERIAL_COMMAND_PROTO;
+        } else if (strncmp(command->text, "PUSH:", 5) == 0) {
+            command->type = SERIAL_COMMAND_PUSH;
+        } else if (strcmp(command->text, "ACK") == 0) {
+            command->type = SERIAL_COMMAND_ACK;
+        } else {
+            command->type = SERIAL_COMMAND_UNKNOWN;
         }
-        
-        return -1;  // Read error
-    } else if (select_result == 0) {
-        // Timeout occurred
-        return 0;
-    } else {
-        // Error occurred
-        LOG_MESSAGE_ERR("Select error: %s", strerror(errno));
-        return -1;
+        batch->count++;
     }
+    
+    if (batch->count > 0) {
+        latency_mark(LATENCY_PARSED);
+    }
+    
+    if (batch->coalesced > 0) {
+        metrics_add(METRIC_POLLS_COALESCED, batch->coalesced);
+        if (g_config.verbose) {
+            LOG_MESSAGE_DEBUG("Coalesced %d duplicate POLL commands", batch->coalesced);
+        }
+    }
+    
+    return batch->count;
 }
 
 /**
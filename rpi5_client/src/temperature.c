@@ -4,102 +4,321 @@
  */
 
 #include "temperature.h"
+#include "config.h"
+#include "coprocess.h"
+#include "command.h"
+#include "sensors.h"
 #include "logger.h"
+#include "metrics.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
+
+#define CPU_TEMP_MAX  120.0f   // Sanity limits for readings (exclusive)
+#define NVME_TEMP_MAX 150.0f
+
+// Native sensors, discovered and opened once at startup and kept for the daemon's lifetime
+static sensor_group_t g_cpu_sensors;
+static sensor_group_t g_nvme_sensors;
+
+// Persistent sensor commands (coproc source)
+static coprocess_t g_cpu_coproc = {.pid = -1, .fd = -1};
+static coprocess_t g_nvme_coproc = {.pid = -1, .fd = -1};
+
+// Sensor command latency statistics (cmd source and fallback)
+static command_stats_t g_cpu_cmd_stats = {.name = "CPU"};
+static command_stats_t g_nvme_cmd_stats = {.name = "NVME"};
+
+// Last good readings, reported when a read fails (initially the default fallback values)
+static float g_cpu_last_good = 61.0;
+static float g_nvme_last_good = 59.0;
+
+/**
+ * Parse one line of NVME coprocess output: smartctl format or a plain number
+ */
+static int parse_nvme_reading(const char *line, float *temp) {
+    if (temperature_parse_nvme_line(line, temp) == 0) {
+        return 0;
+    }
+    
+    return temperature_parse_cpu(line, temp);
+}
+
+/**
+ * Open native temperature sensors according to configuration
+ */
+int temperature_init(void) {
+    sensors_group_init(&g_cpu_sensors, "CPU", g_config.cpu_aggregate, CPU_TEMP_MAX);
+    sensors_group_init(&g_nvme_sensors, "NVME", g_config.nvme_aggregate, NVME_TEMP_MAX);
+    
+    if (g_config.cpu_source == TEMP_SOURCE_COPROC) {
+        if (coprocess_start(&g_cpu_coproc, "CPU", g_config.cpu_temp_cmd, temperature_parse_cpu,
+                            g_config.coproc_max_age_ms) != 0) {
+            return -1;
+        }
+    } else if (g_config.cpu_source != TEMP_SOURCE_CMD) {
+        if (g_config.cpu_sensor_path != NULL) {
+            sensors_add_paths(&g_cpu_sensors, g_config.cpu_sensor_path);
+        } else {
+            sensors_discover_cpu(&g_cpu_sensors);
+        }
+        
+        if (g_cpu_sensors.count > 0) {
+            sensors_log_group(&g_cpu_sensors);
+        } else if (g_config.cpu_source == TEMP_SOURCE_NATIVE) {
+            LOG_MESSAGE_ERR("Failed to open native CPU temperature sensor%s%s",
+                            g_config.cpu_sensor_path ? " " : "",
+                            g_config.cpu_sensor_path ? g_config.cpu_sensor_path : "");
+            return -1;
+        } else {
+            LOG_MESSAGE_WARNING("No native CPU temperature sensor, falling back to command");
+        }
+    }
+    
+    if (g_cpu_sensors.count == 0 && g_config.cpu_source != TEMP_SOURCE_COPROC) {
+        if (g_config.cpu_temp_cmd == NULL) {
+            LOG_MESSAGE_ERR("No CPU temperature source available");
+            return -1;
+        }
+        LOG_MESSAGE_INFO("CPU temperature source: %s (command)", g_config.cpu_temp_cmd);
+    }
+    
+    if (g_config.nvme_source == TEMP_SOURCE_COPROC) {
+        if (coprocess_start(&g_nvme_coproc, "NVME", g_config.nvme_temp_cmd, parse_nvme_reading,
+                            g_config.coproc_max_age_ms) != 0) {
+            return -1;
+        }
+    } else if (g_config.nvme_source != TEMP_SOURCE_CMD) {
+        // hwmon of every controller; admin ioctl on the configured device without hwmon
+        sensors_discover_nvme(&g_nvme_sensors);
+        
+        if (g_nvme_sensors.count > 0) {
+            sensors_log_group(&g_nvme_sensors);
+        } else if (g_config.nvme_source == TEMP_SOURCE_NATIVE) {
+            LOG_MESSAGE_ERR("Failed to open native NVME temperature sensor for %s", g_config.nvme_device);
+            return -1;
+        } else {
+            LOG_MESSAGE_WARNING("No native NVME temperature sensor, falling back to command");
+        }
+    }
+    
+    if (g_nvme_sensors.count == 0 && g_config.nvme_source != TEMP_SOURCE_COPROC) {
+        if (g_config.nvme_temp_cmd == NULL) {
+            LOG_MESSAGE_ERR("No NVME temperature source available");
+            return -1;
+        }
+        LOG_MESSAGE_INFO("NVME temperature source: %s (command)", g_config.nvme_temp_cmd);
+    }
+    
+    return 0;
+}
 
 /**
- * Get CPU temperature using vcgencmd
+ * Close native temperature sensors
  */
-float temperature_get_cpu(const char *cmd) {
-    FILE *fp;
-    char result[64];
-    float temp = 61.0;  // Default fallback value
+void temperature_cleanup(void) {
+    sensors_close(&g_cpu_sensors);
+    sensors_close(&g_nvme_sensors);
+    
+    coprocess_stop(&g_cpu_coproc);
+    coprocess_stop(&g_nvme_coproc);
+}
+
+/**
+ * Parse a sysfs millidegree integer (e.g. "45123\n")
+ */
+int temperature_parse_millidegrees(const char *text, float *temp) {
+    char *end;
+    
+    errno = 0;
+    long millideg = strtol(text, &end, 10);
+    if (errno != 0 || end == text) {
+        return -1;
+    }
+    
+    *temp = millideg / 1000.0f;
+    return 0;
+}
+
+/**
+ * Parse CPU temperature command output
+ * Accepts vcgencmd format (temp=XX.X'C) and raw thermal_zone millidegrees
+ */
+int temperature_parse_cpu(const char *text, float *temp) {
+    // vcgencmd format: temp=XX.X'C
+    const char *temp_str = strstr(text, "temp=");
+    if (temp_str != NULL) {
+        return sscanf(temp_str + 5, "%f", temp) == 1 ? 0 : -1;
+    }
+    
+    // Plain number: millidegrees from sysfs, or degrees from a custom script
+    char *end;
+    float value = strtof(text, &end);
+    if (end == text) {
+        return -1;
+    }
+    
+    *temp = value >= 1000.0f ? value / 1000.0f : value;
+    return 0;
+}
+
+/**
+ * Parse a smartctl output line ("Temperature:   45 Celsius")
+ */
+int temperature_parse_nvme_line(const char *line, float *temp) {
+    // Look for line starting with "Temperature:"
+    if (strncmp(line, "Temperature:", 12) != 0) {
+        return -1;
+    }
+    
+    // Find the temperature value after "Temperature:"
+    const char *temp_str = line + 12;  // Skip "Temperature:"
+    
+    // Skip whitespace
+    while (*temp_str == ' ' || *temp_str == '\t') {
+        temp_str++;
+    }
+    
+    // Parse the temperature value
+    *temp = atof(temp_str);
+    return 0;
+}
+
+/**
+ * Get CPU temperature from the native sensor or the configured command
+ * Returns 0 on success, -1 when the read failed and temp holds the last good reading
+ */
+int temperature_get_cpu(const char *cmd, float *temp) {
+    char result[256];
+    float parsed_temp;
+    
+    *temp = g_cpu_last_good;
+    
+    // Persistent command - latest line it has written, no process creation
+    if (g_config.cpu_source == TEMP_SOURCE_COPROC) {
+        if (coprocess_poll(&g_cpu_coproc, &parsed_temp) == 0 && parsed_temp > 0 && parsed_temp < CPU_TEMP_MAX) {
+            g_cpu_last_good = parsed_temp;
+            *temp = parsed_temp;
+            return 0;
+        }
+        metrics_inc(METRIC_SENSOR_ERRORS);
+        return -1;
+    }
+    
+    // Native sensors, aggregated over the group - no process creation
+    if (g_cpu_sensors.count > 0) {
+        if (sensors_read(&g_cpu_sensors, &parsed_temp) == 0) {
+            g_cpu_last_good = parsed_temp;
+            *temp = parsed_temp;
+            return 0;
+        }
+        
+        metrics_inc(METRIC_SENSOR_ERRORS);
+        if (g_config.verbose) {
+            LOG_MESSAGE_DEBUG("Failed to read native CPU sensors: %s", strerror(errno));
+        }
+        
+        if (g_config.cpu_source == TEMP_SOURCE_NATIVE) {
+            return -1;
+        }
+    }
     
     if (cmd == NULL) {
         LOG_MESSAGE_ERR("CPU temperature command is NULL");
-        return temp;
-    }
-    
-    // Execute command to get CPU temperature
-    fp = popen(cmd, "r");
-    if (fp == NULL) {
-        LOG_MESSAGE_ERR("Failed to run CPU temperature command: %s", strerror(errno));
-        return temp;
-    }
-    
-    // Read the output
-    if (fgets(result, sizeof(result), fp) != NULL) {
-        // Parse the temperature value (format: temp=XX.X'C)
-        char *temp_str = strstr(result, "temp=");
-        if (temp_str != NULL) {
-            float parsed_temp;
-            if (sscanf(temp_str + 5, "%f", &parsed_temp) == 1) {
-                if (parsed_temp > 0 && parsed_temp < 120) {  // Sanity check
-                    temp = parsed_temp;
-                }
-            }
-        }
+        return -1;
+    }
+    
+    // Execute command to get CPU temperature, bounded by the command deadline
+    if (command_run(cmd, result, sizeof(result), g_config.cmd_timeout_ms, &g_cpu_cmd_stats) > 0 &&
+        temperature_parse_cpu(result, &parsed_temp) == 0 &&
+        parsed_temp > 0 && parsed_temp < CPU_TEMP_MAX) {  // Sanity check
+        g_cpu_last_good = parsed_temp;
+        *temp = parsed_temp;
+        return 0;
     }
     
-    pclose(fp);
-    return temp;
+    metrics_inc(METRIC_SENSOR_ERRORS);
+    return -1;
 }
 
 /**
- * Get NVME temperature using smartctl
+ * Get NVME temperature from the native sensor or the configured command
+ * Returns 0 on success, -1 when the read failed and temp holds the last good reading
  */
-float temperature_get_nvme(const char *cmd) {
-    FILE *fp;
-    char line[256];
-    float temp = 59.0;  // Default value
+int temperature_get_nvme(const char *cmd, float *temp) {
+    char output[4096];
+    float parsed_temp;
+    
+    *temp = g_nvme_last_good;
+    
+    // Persistent command - latest line it has written, no process creation
+    if (g_config.nvme_source == TEMP_SOURCE_COPROC) {
+        if (coprocess_poll(&g_nvme_coproc, &parsed_temp) == 0 && parsed_temp > 0 && parsed_temp < NVME_TEMP_MAX) {
+            g_nvme_last_good = parsed_temp;
+            *temp = parsed_temp;
+            return 0;
+        }
+        metrics_inc(METRIC_SENSOR_ERRORS);
+        return -1;
+    }
+    
+    // Native hwmon or admin ioctl, aggregated over all drives - no process creation
+    if (g_nvme_sensors.count > 0) {
+        if (sensors_read(&g_nvme_sensors, &parsed_temp) == 0) {
+            g_nvme_last_good = parsed_temp;
+            *temp = parsed_temp;
+            return 0;
+        }
+        
+        metrics_inc(METRIC_SENSOR_ERRORS);
+        if (g_config.verbose) {
+            LOG_MESSAGE_DEBUG("Failed to read native NVME sensors: %s", strerror(errno));
+        }
+        
+        if (g_config.nvme_source == TEMP_SOURCE_NATIVE) {
+            return -1;
+        }
+    }
     
     if (cmd == NULL) {
         LOG_MESSAGE_ERR("NVME temperature command is NULL");
-        return temp;
-    }
-    
-    // Execute command to get NVME temperature
-    fp = popen(cmd, "r");
-    if (fp == NULL) {
-        LOG_MESSAGE_ERR("Failed to run NVME temperature command: %s", strerror(errno));
-        return temp;
-    }
-    
-    // Read the output and parse temperature
-    while (fgets(line, sizeof(line), fp) != NULL) {
-        // Look for line starting with "Temperature:"
-        if (strncmp(line, "Temperature:", 12) == 0) {
-            // Find the temperature value after "Temperature:"
-            char *temp_str = line + 12;  // Skip "Temperature:"
-            
-            // Skip whitespace
-            while (*temp_str == ' ' || *temp_str == '\t') {
-                temp_str++;
-            }
-            
-            // Parse the temperature value
-            float parsed_temp = atof(temp_str);
-            if (parsed_temp > 0 && parsed_temp < 150) {  // Sanity check (0-150°C)
-                temp = parsed_temp;
-                break;  // Found the temperature, stop reading
+        return -1;
+    }
+    
+    // Execute command to get NVME temperature, bounded by the command deadline
+    if (command_run(cmd, output, sizeof(output), g_config.cmd_timeout_ms, &g_nvme_cmd_stats) <= 0) {
+        metrics_inc(METRIC_SENSOR_ERRORS);
+        return -1;
+    }
+    
+    // Parse the output line by line
+    char *line = output;
+    while (line != NULL) {
+        char *next = strchr(line, '\n');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        
+        if (temperature_parse_nvme_line(line, &parsed_temp) == 0) {
+            if (parsed_temp > 0 && parsed_temp < NVME_TEMP_MAX) {  // Sanity check (0-150°C)
+                g_nvme_last_good = parsed_temp;
+                *temp = parsed_temp;
+                return 0;
             }
         }
+        line = next;
     }
     
-    pclose(fp);
-    return temp;
+    metrics_inc(METRIC_SENSOR_ERRORS);
+    return -1;
 }
 
 /**
- * Format temperature response string
+ * Log latency statistics of the sensor commands that have been run
  */
-int temperature_format_response(char *buffer, size_t size, float cpu_temp, float nvme_temp) {
-    if (buffer == NULL || size == 0) {
-        return -1;
-    }
-    
-    return snprintf(buffer, size, "CPU:%.2f|NVME:%.2f\n", cpu_temp, nvme_temp);
+void temperature_log_command_stats(void) {
+    command_log_stats(&g_cpu_cmd_stats);
+    command_log_stats(&g_nvme_cmd_stats);
 }
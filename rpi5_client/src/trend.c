@@ -0,0 +1,68 @@
+/**
+ * Trend module for Fan Temperature Daemon
+ * Keeps recent readings of a sensor and estimates how fast it is heating up
+ */
+
+#include "trend.h"
+#include <string.h>
+
+/**
+ * Initialize an empty trend window of the given number of samples
+ */
+void trend_init(trend_t *trend, int capacity) {
+    memset(trend, 0, sizeof(*trend));
+    
+    if (capacity > TREND_MAX_SAMPLES) {
+        capacity = TREND_MAX_SAMPLES;
+    }
+    trend->capacity = capacity;
+}
+
+/**
+ * Add a reading, replacing the oldest one when the window is full
+ */
+void trend_add(trend_t *trend, int64_t time_ns, float value) {
+    if (trend->capacity <= 0) {
+        return;
+    }
+    
+    trend->times_ns[trend->next] = time_ns;
+    trend->values[trend->next] = value;
+    trend->next = (trend->next + 1) % trend->capacity;
+    if (trend->count < trend->capacity) {
+        trend->count++;
+    }
+}
+
+/**
+ * Least squares slope of the readings in degrees per second
+ * Returns 0 until at least two readings at different times are available
+ */
+float trend_slope(const trend_t *trend) {
+    double sum_x = 0, sum_y = 0, sum_xy = 0, sum_xx = 0;
+    int n = trend->count;
+    
+    if (n < 2) {
+        return 0.0f;
+    }
+    
+    // Times relative to the newest reading keep the sums small and precise
+    int64_t origin_ns = trend->times_ns[(trend->next + trend->capacity - 1) % trend->capacity];
+    
+    for (int i = 0; i < n; i++) {
+        double x = (trend->times_ns[i] - origin_ns) / 1e9;
+        double y = trend->values[i];
+        
+        sum_x += x;
+        sum_y += y;
+        sum_xy += x * y;
+        sum_xx += x * x;
+    }
+    
+    double denominator = n * sum_xx - sum_x * sum_x;
+    if (denominator <= 0) {
+        return 0.0f;
+    }
+    
+    return (float)((n * sum_xy - sum_x * sum_y) / denominator);
+}
@@ -6,6 +6,7 @@
 #include "utils.h"
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
 
 /**
  * Clean received buffer by removing whitespace and line endings
@@ -44,3 +45,12 @@ void utils_sleep_ms(int milliseconds) {
         usleep(milliseconds * 1000);
     }
 }
+
+/**
+ * Get CLOCK_MONOTONIC time in nanoseconds
+ */
+int64_t utils_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+/**
+ * Sensor discovery check for Fan Temperature Daemon
+ * Runs CPU and NVME discovery against a fake sysfs tree and prints every
+ * sensor found with its reading, one line each, paths relative to the tree
+ * `make sensortest` compares the output with test/sysfs/<tree>.expected
+ */
+
+#include "config.h"
+#include "sensors.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Print the sensors of a group and its aggregate
+ */
+static void print_group(sensor_group_t *group, const char *root) {
+    size_t root_len = strlen(root);
+    float temp;
+    
+    for (int i = 0; i < group->count; i++) {
+        const sensor_t *sensor = &group->sensors[i];
+        const char *path = sensor->path;
+        
+        if (strncmp(path, root, root_len) == 0 && path[root_len] == '/') {
+            path += root_len + 1;
+        }
+        printf("%s %s %s %.1f\n", group->name, sensor->label, path, sensor->value);
+    }
+    
+    if (sensors_read(group, &temp) == 0) {
+        printf("%s aggregate %.1f\n", group->name, temp);
+    } else {
+        printf("%s aggregate none\n", group->name);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static sensor_group_t cpu;
+    static sensor_group_t nvme;
+    
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <sysfs root>\n", argv[0]);
+        return 2;
+    }
+    
+    g_config.sysfs_root = argv[1];
+    g_config.nvme_device = DEFAULT_NVME_DEVICE;
+    
+    sensors_group_init(&cpu, "CPU", TEMP_AGGREGATE_MAX, 120.0f);
+    sensors_group_init(&nvme, "NVME", TEMP_AGGREGATE_MAX, 150.0f);
+    sensors_discover_cpu(&cpu);
+    sensors_discover_nvme(&nvme);
+    
+    print_group(&cpu, argv[1]);
+    print_group(&nvme, argv[1]);
+    
+    sensors_close(&cpu);
+    sensors_close(&nvme);
+    return 0;
+}
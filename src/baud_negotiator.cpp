@@ -0,0 +1,131 @@
+#include "baud_negotiator.h"
+#include <Arduino.h>
+
+// Alternating bits ('U', '5') and runs of equal bits ('~', '0') expose a rate the link cannot carry
+static const char ECHO_PATTERN[] = "U5U5~~00UUaa||zz";
+
+BaudNegotiator::BaudNegotiator()
+    : channel(nullptr),
+      deviceId(0),
+      rateIndex(0),
+      ceilingIndex(NUM_BAUD_RATES - 1),
+      missedPolls(0),
+      waitStart(0),
+      waitDuration(0) {
+}
+
+void BaudNegotiator::begin(SerialChannel* serialChannel, int device) {
+    channel = serialChannel;
+    deviceId = device;
+    rateIndex = 0;
+}
+
+bool BaudNegotiator::shouldNegotiate() const {
+    return BAUD_NEGOTIATION && channel != nullptr && rateIndex < ceilingIndex &&
+           millis() - waitStart >= waitDuration;
+}
+
+bool BaudNegotiator::negotiate() {
+    char command[MAX_NEGOTIATION_LENGTH + 1];
+    char line[MAX_NEGOTIATION_LENGTH + 1];
+    int previous = rateIndex;
+    int next = rateIndex + 1;
+    
+    snprintf(command, sizeof(command), "BAUD:%ld", BAUD_RATES[next]);
+    channel->writeLine(command);
+    
+    if (!channel->awaitLine("BAUD:", line, sizeof(line), RESPONSE_TIMEOUT)) {
+        // Daemon without negotiation support, or not running
+        postpone(BAUD_RETRY_INTERVAL);
+        return false;
+    }
+    
+    if (strncmp(line, "BAUD:NO", 7) == 0) {
+        ceilingIndex = rateIndex;
+        Serial.print(F("Device "));
+        Serial.print(deviceId + 1);
+        Serial.print(F(" refused "));
+        Serial.print(BAUD_RATES[next]);
+        Serial.println(F(" baud"));
+        return false;
+    }
+    
+    snprintf(command, sizeof(command), "BAUD:OK:%ld", BAUD_RATES[next]);
+    if (strcmp(line, command) != 0) {
+        postpone(BAUD_RETRY_INTERVAL);
+        return false;
+    }
+    
+    setRate(next);
+    delay(BAUD_SWITCH_DELAY);
+    
+    if (echoTest()) {
+        channel->writeLine("BAUD:COMMIT");
+        if (channel->awaitLine("BAUD:", line, sizeof(line), RESPONSE_TIMEOUT) && strcmp(line, "BAUD:OK") == 0) {
+            Serial.print(F("Device "));
+            Serial.print(deviceId + 1);
+            Serial.print(F(" negotiated "));
+            Serial.print(BAUD_RATES[next]);
+            Serial.println(F(" baud"));
+            return true;
+        }
+    }
+    
+    // The daemon returns to the previous rate by itself when the commit does not arrive
+    setRate(previous);
+    postpone(BAUD_RETRY_INTERVAL);
+    Serial.print(F("Device "));
+    Serial.print(deviceId + 1);
+    Serial.print(F(" failed echo test at "));
+    Serial.print(BAUD_RATES[next]);
+    Serial.println(F(" baud"));
+    return false;
+}
+
+void BaudNegotiator::recordPoll(bool answered) {
+    if (answered) {
+        missedPolls = 0;
+        return;
+    }
+    
+    if (rateIndex > 0 && ++missedPolls >= BAUD_FALLBACK_MISSES) {
+        Serial.print(F("Device "));
+        Serial.print(deviceId + 1);
+        Serial.print(F(" silent at "));
+        Serial.print(BAUD_RATES[rateIndex]);
+        Serial.println(F(" baud, returning to base rate"));
+        
+        setRate(0);
+        postpone(BAUD_RENEGOTIATE_DELAY);
+    }
+}
+
+long BaudNegotiator::getBaudRate() const {
+    return BAUD_RATES[rateIndex];
+}
+
+bool BaudNegotiator::echoTest() {
+    char command[MAX_NEGOTIATION_LENGTH + 1];
+    char line[MAX_NEGOTIATION_LENGTH + 1];
+    
+    for (int i = 0; i < BAUD_ECHO_COUNT; i++) {
+        snprintf(command, sizeof(command), "ECHO:%d:%s", i, ECHO_PATTERN);
+        channel->writeLine(command);
+        
+        if (!channel->awaitLine("ECHO:", line, sizeof(line), RESPONSE_TIMEOUT) || strcmp(line, command) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BaudNegotiator::setRate(int index) {
+    rateIndex = index;
+    missedPolls = 0;
+    channel->begin(BAUD_RATES[index]);
+}
+
+void BaudNegotiator::postpone(unsigned long duration) {
+    waitStart = millis();
+    waitDuration = duration;
+}
@@ -5,9 +5,14 @@ DeviceCommunication::DeviceCommunication()
       device2(DEVICE2_RX_PIN, DEVICE2_TX_PIN),
       device3(DEVICE3_RX_PIN, DEVICE3_TX_PIN),
       device4(DEVICE4_RX_PIN, DEVICE4_TX_PIN),
+      received(0),
       lastPollTime(0),
       commandSentTime(0),
       currentPollingDevice(-1),
+      listeningDevice(-1),
+      listenStart(0),
+      listenHeard(false),
+      resyncing(false),
       tempSensor(nullptr) {
     
     devices[0] = &device1;
@@ -16,7 +21,7 @@ DeviceCommunication::DeviceCommunication()
     devices[3] = &device4;
     
     for (int i = 0; i < NUM_DEVICES; i++) {
-        incomingData[i] = "";
+        channels[i] = SoftwareSerialChannel(devices[i]);
         deviceResponded[i] = false;
     }
 }
@@ -36,20 +41,26 @@ void DeviceCommunication::begin(TemperatureSensor* temperatureSensor) {
     device3.stopListening();
     device4.stopListening();
     
+    // Every device starts at the base rate; faster rates are negotiated while polling
+    for (int i = 0; i < NUM_DEVICES; i++) {
+        negotiators[i].begin(&channels[i], i);
+        protocols[i].begin(&channels[i], i);
+    }
+    
     // Debug: Print SoftwareSerial initialization
-    Serial.println("SoftwareSerial initialization:");
+    Serial.println(F("SoftwareSerial initialization:"));
     for(int i = 0; i < NUM_DEVICES; i++) {
-        Serial.print("Device ");
+        Serial.print(F("Device "));
         Serial.print(i + 1);
-        Serial.print(": listening=");
+        Serial.print(F(": listening="));
         Serial.print(devices[i]->isListening());
-        Serial.print(" baud=");
+        Serial.print(F(" baud="));
         Serial.println(BAUD_RATE);
     }
     
-    Serial.println("Device communication initialized");
-    Serial.println("Ready to communicate with 4 devices via SoftwareSerial");
-    Serial.println("Polling for temperature data in format CPU:xx.x|NVME:xx.x");
+    Serial.println(F("Device communication initialized"));
+    Serial.println(F("Ready to communicate with 4 devices via SoftwareSerial"));
+    Serial.println(F("Polling for temperature data in format CPU:xx.x|NVME:xx.x, or binary where supported"));
 }
 
 void DeviceCommunication::pollDevices() {
@@ -59,7 +70,16 @@ void DeviceCommunication::pollDevices() {
     if (currentPollingDevice == -1 && currentMillis - lastPollTime >= POLL_INTERVAL) {
         currentPollingDevice = 0;
         lastPollTime = currentMillis;
-        Serial.println("Starting device polling sequence");
+    }
+    
+    // Devices in push mode report on their own; poll them only when their updates stop
+    while (currentPollingDevice >= 0 && commandSentTime == 0 &&
+           protocols[currentPollingDevice].isPushing()) {
+        if (protocols[currentPollingDevice].isStale()) {
+            protocols[currentPollingDevice].pushLost();
+            break;
+        }
+        advancePolling();
     }
     
     // If we're in the middle of polling
@@ -73,6 +93,9 @@ void DeviceCommunication::pollDevices() {
             
             // Start listening on current device
             devices[currentPollingDevice]->listen();
+            listeningDevice = currentPollingDevice;
+            resyncing = false;
+            received = 0;
             
             // Give some time for the port to stabilize after switching
             delay(PORT_SWITCH_DELAY);
@@ -82,88 +105,145 @@ void DeviceCommunication::pollDevices() {
                 devices[currentPollingDevice]->read();
             }
             
+            // Step up to a faster baud rate first if one is due
+            if (negotiators[currentPollingDevice].shouldNegotiate()) {
+                negotiators[currentPollingDevice].negotiate();
+                currentMillis = millis();
+            }
+            
+            // Then ask for binary or extended responses if the device has not confirmed them yet
+            if (protocols[currentPollingDevice].shouldNegotiate()) {
+                protocols[currentPollingDevice].negotiate();
+                currentMillis = millis();
+            }
+            
+            // Let the daemon push its updates from now on; this poll still answers right away
+            if (protocols[currentPollingDevice].shouldRequestPush()) {
+                protocols[currentPollingDevice].requestPush();
+                currentMillis = millis();
+            }
+            
             // Send poll command to current device
-            devices[currentPollingDevice]->println("POLL");
+            const char* command = protocols[currentPollingDevice].isBinary() ? "POLL:BIN"
+                                : protocols[currentPollingDevice].isExtended() ? "POLL:EXT" : "POLL";
+            devices[currentPollingDevice]->println(command);
+            received = 0;
             
             // Ensure data is sent before continuing
             devices[currentPollingDevice]->flush();
             
             commandSentTime = currentMillis;
-            Serial.print("Polling device ");
-            Serial.print(currentPollingDevice + 1);
-            Serial.println(" (sent: POLL)");
         }
-
+        
         // Check if the current device has data available
         if (devices[currentPollingDevice]->available()) {
-            char c = devices[currentPollingDevice]->read();
-            if (c == '\n') {
-                // Process the complete response
-                processSerialResponse(currentPollingDevice, incomingData[currentPollingDevice]);
-                incomingData[currentPollingDevice] = "";
+            // Garbage at a bad baud rate, or a frame that fails its CRC, counts as a miss
+            int result = receiveByte(currentPollingDevice, devices[currentPollingDevice]->read());
+            if (result >= 0) {
+                negotiators[currentPollingDevice].recordPoll(result == 1);
+                protocols[currentPollingDevice].recordPoll(result == 1);
                 deviceResponded[currentPollingDevice] = true;
-            } else if (c != '\r') {
-                // Prevent buffer overflow - limit message length
-                if (incomingData[currentPollingDevice].length() < 64) {
-                    incomingData[currentPollingDevice] += c;
-                } else {
-                    // Buffer overflow protection - reset and ignore
-                    incomingData[currentPollingDevice] = "";
-                    Serial.print("Buffer overflow on device ");
-                    Serial.println(currentPollingDevice + 1);
-                }
             }
         }
-
+        
         // Check for timeout or if device responded
         if (deviceResponded[currentPollingDevice] || 
             (commandSentTime > 0 && currentMillis - commandSentTime >= RESPONSE_TIMEOUT)) {
-
+            
             if (!deviceResponded[currentPollingDevice]) {
-                Serial.print("Device ");
+                negotiators[currentPollingDevice].recordPoll(false);
+                protocols[currentPollingDevice].recordPoll(false);
+                
+                Serial.print(F("Device "));
                 Serial.print(currentPollingDevice + 1);
-                Serial.println(" did not respond");
+                Serial.println(F(" did not respond"));
                 
                 // Handle missed poll
                 if (tempSensor) {
                     tempSensor->handleMissedPoll(currentPollingDevice);
                 }
             }
-
-            // Move to next device
-            deviceResponded[currentPollingDevice] = false;
-            commandSentTime = 0;
-            currentPollingDevice++;
             
-            // If we've polled all devices, reset
-            if (currentPollingDevice >= NUM_DEVICES) {
-                currentPollingDevice = -1;
-                Serial.println("Completed polling all devices");
-                
-                // After polling all devices, print a summary of temperatures
-                if (tempSensor) {
-                    tempSensor->printTemperatureSummary();
-                }
-            }
+            advancePolling();
         }
     }
 }
 
-void DeviceCommunication::processSerialResponse(int deviceId, const String& response) {
-    Serial.print("Device ");
-    Serial.print(deviceId + 1);
-    Serial.print(" sent: ");
-    Serial.println(response);
+void DeviceCommunication::advancePolling() {
+    // Move to next device
+    deviceResponded[currentPollingDevice] = false;
+    commandSentTime = 0;
+    currentPollingDevice++;
     
+    // If we've polled all devices, reset
+    if (currentPollingDevice >= NUM_DEVICES) {
+        currentPollingDevice = -1;
+        
+        // After polling all devices, print a summary of temperatures
+        if (tempSensor) {
+            tempSensor->printTemperatureSummary();
+        }
+    }
+}
+
+int DeviceCommunication::receiveByte(int deviceId, int c) {
+    bool binary = protocols[deviceId].isBinary();
+    
+    // The tail of an update that started before listening cannot be valid
+    if (resyncing) {
+        if (c == (binary ? 0 : '\n')) {
+            resyncing = false;
+            received = 0;
+        }
+        return -1;
+    }
+    
+    if (binary) {
+        if (c == 0 && received > 0) {
+            // A complete frame
+            bool valid = processBinaryResponse(deviceId, frame, received);
+            received = 0;
+            return valid ? 1 : 0;
+        } else if (c != 0) {
+            if (received < sizeof(frame)) {
+                frame[received++] = (uint8_t)c;
+            } else {
+                // No valid frame is this long - wait for the next delimiter
+                received = 0;
+                Serial.print(F("Frame overflow on device "));
+                Serial.println(deviceId + 1);
+            }
+        }
+    } else if (c == '\n') {
+        // Process the complete response
+        line[received] = '\0';
+        bool valid = processSerialResponse(deviceId, line);
+        received = 0;
+        return valid ? 1 : 0;
+    } else if (c != '\r') {
+        // Prevent buffer overflow - limit message length
+        if (received < MAX_RESPONSE_LENGTH) {
+            line[received++] = (char)c;
+        } else {
+            // Buffer overflow protection - reset and ignore
+            received = 0;
+            Serial.print(F("Buffer overflow on device "));
+            Serial.println(deviceId + 1);
+        }
+    }
+    return -1;
+}
+
+bool DeviceCommunication::processSerialResponse(int deviceId, const char* response) {
     // Clean the response by removing any whitespace and line endings
     String cleanResponse = response;
     cleanResponse.trim();
     
     // Validate response format and length
-    if (cleanResponse.length() > 32 || cleanResponse.length() < 6) {
-        Serial.print("Invalid response length from device ");
+    if (cleanResponse.length() > MAX_RESPONSE_LENGTH || cleanResponse.length() < 6) {
+        Serial.print(F("Invalid response length from device "));
         Serial.println(deviceId + 1);
-        return;
+        return false;
     }
     
     // CPU:xx.x|NVME:xx.x (temperature data)
@@ -172,11 +252,39 @@ void DeviceCommunication::processSerialResponse(int deviceId, const String& resp
         if (tempSensor && tempSensor->parseTemperatureData(deviceId, cleanResponse)) {
             // Reset missed polls counter on successful data reception
             tempSensor->resetMissedPolls(deviceId);
+            return true;
         }
     } else {
-        Serial.print("Got unknown response: ");
+        Serial.print(F("Got unknown response: "));
         Serial.println(cleanResponse);
     }
+    return false;
+}
+
+bool DeviceCommunication::processBinaryResponse(int deviceId, const uint8_t* frameData, size_t length) {
+    wire_temperatures_t values;
+    
+    if (wire_decode_temperatures(frameData, length, &values) != 0) {
+        Serial.print(F("Corrupted binary response from device "));
+        Serial.println(deviceId + 1);
+        return false;
+    }
+    
+    if (!tempSensor) {
+        return false;
+    }
+    
+    // Fixed-point fields convert directly, without parsing text
+    bool trend = values.flags & WIRE_FLAG_TREND;
+    tempSensor->updateTemperatureData(deviceId,
+                                      values.cpu_centi / 100.0,
+                                      values.nvme_centi / 100.0,
+                                      values.age_ms,
+                                      trend ? values.cpu_slope_centi / 100.0 : 0.0,
+                                      trend ? values.nvme_slope_centi / 100.0 : 0.0,
+                                      (values.flags & WIRE_FLAG_LOAD) ? min((int)values.load_pct, 100) : -1);
+    tempSensor->resetMissedPolls(deviceId);
+    return true;
 }
 
 void DeviceCommunication::checkIncomingData() {
@@ -186,20 +294,50 @@ void DeviceCommunication::checkIncomingData() {
         return; // Skip if we're in the middle of polling
     }
     
-    // Check for direct commands from devices (outside of polling)
+    // Pushing devices take turns on the one port SoftwareSerial can listen to
+    rotateListening();
+    
+    // Check for direct commands and push updates from devices (outside of polling)
     for (int i = 0; i < NUM_DEVICES; i++) {
-        if (devices[i]->available()) {
-            char c = devices[i]->read();
-            if (c == '\n') {
-                processSerialResponse(i, incomingData[i]);
-                incomingData[i] = "";
-            } else if (c != '\r') {
-                incomingData[i] += c;
+        while (devices[i]->available()) {
+            listenHeard = true;
+            if (receiveByte(i, devices[i]->read()) == 1 && protocols[i].isPushing()) {
+                // Stops the daemon repeating this update
+                devices[i]->println("ACK");
+                protocols[i].recordPush();
+                negotiators[i].recordPoll(true);
+                listenHeard = false;
             }
         }
     }
 }
 
+void DeviceCommunication::rotateListening() {
+    unsigned long elapsed = millis() - listenStart;
+    
+    // Stay while an update is coming in; a turn that started mid-update waits for its repeat
+    if (elapsed < LISTEN_SLOT || (listenHeard && elapsed < 3 * LISTEN_SLOT)) {
+        return;
+    }
+    
+    for (int n = 1; n <= NUM_DEVICES; n++) {
+        int next = (listeningDevice + n) % NUM_DEVICES;
+        if (!protocols[next].isPushing()) {
+            continue;
+        }
+        
+        if (next != listeningDevice) {
+            devices[next]->listen();
+            listeningDevice = next;
+            resyncing = true;
+            received = 0;
+        }
+        listenStart = millis();
+        listenHeard = false;
+        return;
+    }
+}
+
 SoftwareSerial* DeviceCommunication::getDevice(int deviceId) {
     if (deviceId >= 0 && deviceId < NUM_DEVICES) {
         return devices[deviceId];
@@ -9,7 +9,7 @@ void FanController::begin() {
     pinMode(FAN_PWM_PIN, OUTPUT);
     currentPwmValue = FAN_SPEED_MIN;
     analogWrite(FAN_PWM_PIN, currentPwmValue);
-    Serial.println("Fan controller initialized");
+    Serial.println(F("Fan controller initialized"));
 }
 
 int FanController::calculateFanSpeed(float temp, float minTemp, float maxTemp) const {
@@ -25,26 +25,52 @@ int FanController::calculateFanSpeed(float temp, float minTemp, float maxTemp) c
     }
 }
 
+float FanController::calculateTrendBoost(float slope) const {
+    if (slope <= 0.0) {
+        return 0.0;
+    }
+    return min(slope * TREND_LOOKAHEAD_SEC, TREND_MAX_BOOST);
+}
+
+int FanController::calculateLoadFanSpeed(int load) const {
+    if (CONTROL_MODE != CONTROL_TEMPERATURE_AND_LOAD || load <= LOAD_MIN) {
+        return FAN_SPEED_MIN;
+    } else if (load >= LOAD_MAX) {
+        return LOAD_FAN_SPEED_MAX;
+    }
+    return map(load, LOAD_MIN, LOAD_MAX, FAN_SPEED_MIN, LOAD_FAN_SPEED_MAX);
+}
+
 void FanController::updateFanSpeed(const TemperatureSensor& tempSensor) {
     float highestCpuTemp, highestNvmeTemp;
+    float cpuSlope, nvmeSlope;
     tempSensor.getHighestTemperatures(highestCpuTemp, highestNvmeTemp);
+    tempSensor.getHighestSlopes(cpuSlope, nvmeSlope);
     
     // If no temperature data is available at all, set fan to minimum speed
     if (!tempSensor.hasTemperatureData()) {
         currentPwmValue = FAN_SPEED_MIN;
         analogWrite(FAN_PWM_PIN, currentPwmValue);
-        Serial.println("No temperature data available. Fan set to minimum speed.");
+        Serial.println(F("No temperature data available. Fan set to minimum speed."));
         return;
     }
     
+    // Feed-forward: ramp up for the temperature a rising trend is heading to
+    float cpuBoost = calculateTrendBoost(cpuSlope);
+    float nvmeBoost = calculateTrendBoost(nvmeSlope);
+    
     // Calculate fan speed based on CPU temperature
-    int cpuFanSpeed = calculateFanSpeed(highestCpuTemp, CPU_TEMP_MIN, CPU_TEMP_MAX);
+    int cpuFanSpeed = calculateFanSpeed(highestCpuTemp + cpuBoost, CPU_TEMP_MIN, CPU_TEMP_MAX);
     
     // Calculate fan speed based on NVME temperature  
-    int nvmeFanSpeed = calculateFanSpeed(highestNvmeTemp, NVME_TEMP_MIN, NVME_TEMP_MAX);
+    int nvmeFanSpeed = calculateFanSpeed(highestNvmeTemp + nvmeBoost, NVME_TEMP_MIN, NVME_TEMP_MAX);
+    
+    // Calculate fan speed based on CPU load (leads the temperature during load bursts)
+    int highestLoad = tempSensor.getHighestLoad();
+    int loadFanSpeed = calculateLoadFanSpeed(highestLoad);
     
-    // Use the higher of the two calculated fan speeds
-    int newPwmValue = max(cpuFanSpeed, nvmeFanSpeed);
+    // Use the highest of the calculated fan speeds
+    int newPwmValue = max(max(cpuFanSpeed, nvmeFanSpeed), loadFanSpeed);
     
     // Only update if the value has changed
     if (newPwmValue != currentPwmValue) {
@@ -52,30 +78,42 @@ void FanController::updateFanSpeed(const TemperatureSensor& tempSensor) {
         analogWrite(FAN_PWM_PIN, currentPwmValue);
         
         // Log fan speed change
-        Serial.print("Fan speed updated - PWM: ");
+        Serial.print(F("Fan speed updated - PWM: "));
         Serial.print(currentPwmValue);
-        Serial.print(" (");
+        Serial.print(F(" ("));
         Serial.print(getCurrentSpeedPercent());
-        Serial.print("%) | Based on CPU: ");
+        Serial.print(F("%) | Based on CPU: "));
         Serial.print(highestCpuTemp);
-        Serial.print("°C, NVME: ");
+        Serial.print(F("°C, NVME: "));
         Serial.print(highestNvmeTemp);
-        Serial.print("°C");
+        Serial.print(F("°C"));
+        if (cpuBoost > 0.0 || nvmeBoost > 0.0) {
+            Serial.print(F(" (trend +"));
+            Serial.print(cpuBoost);
+            Serial.print(F("/+"));
+            Serial.print(nvmeBoost);
+            Serial.print(F("°C)"));
+        }
+        if (highestLoad >= 0) {
+            Serial.print(F(", load: "));
+            Serial.print(highestLoad);
+            Serial.print(F("%"));
+        }
         
         // Show status of connected/disconnected devices
-        Serial.print(" | Devices: ");
+        Serial.print(F(" | Devices: "));
         for (int i = 0; i < NUM_DEVICES; i++) {
-            if (i > 0) Serial.print(",");
+            if (i > 0) Serial.print(F(","));
             Serial.print(i + 1);
-            Serial.print(":");
+            Serial.print(F(":"));
             if (tempSensor.isDeviceConnected(i)) {
-                Serial.print("ON");
+                Serial.print(F("ON"));
             } else {
                 TemperatureData deviceTemp = tempSensor.getDeviceTemperature(i);
                 if (deviceTemp.isValid && (deviceTemp.cpuTemp > 0.0 || deviceTemp.nvmeTemp > 0.0)) {
-                    Serial.print("OFF(saved)");
+                    Serial.print(F("OFF(saved)"));
                 } else {
-                    Serial.print("OFF");
+                    Serial.print(F("OFF"));
                 }
             }
         }
@@ -91,11 +129,11 @@ void FanController::setFanSpeed(int pwmValue) {
         currentPwmValue = pwmValue;
         analogWrite(FAN_PWM_PIN, currentPwmValue);
         
-        Serial.print("Fan speed manually set to PWM: ");
+        Serial.print(F("Fan speed manually set to PWM: "));
         Serial.print(currentPwmValue);
-        Serial.print(" (");
+        Serial.print(F(" ("));
         Serial.print(getCurrentSpeedPercent());
-        Serial.println("%)");
+        Serial.println(F("%)"));
     }
 }
 
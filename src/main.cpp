@@ -27,21 +27,21 @@ void setup() {
     deviceComm.begin(&tempSensor);
     
     // Log system initialization
-    Serial.println("System Initialized.");
-    Serial.println("Automatic fan control enabled with the following thresholds:");
-    Serial.print("CPU: ");
+    Serial.println(F("System Initialized."));
+    Serial.println(F("Automatic fan control enabled with the following thresholds:"));
+    Serial.print(F("CPU: "));
     Serial.print(CPU_TEMP_MIN);
-    Serial.print("°C - ");
+    Serial.print(F("°C - "));
     Serial.print(CPU_TEMP_MAX);
-    Serial.println("°C");
-    Serial.print("NVME: ");
+    Serial.println(F("°C"));
+    Serial.print(F("NVME: "));
     Serial.print(NVME_TEMP_MIN);
-    Serial.print("°C - ");
+    Serial.print(F("°C - "));
     Serial.print(NVME_TEMP_MAX);
-    Serial.println("°C");
-    Serial.print("Fan curve: Parabolic (exponent = ");
+    Serial.println(F("°C"));
+    Serial.print(F("Fan curve: Parabolic (exponent = "));
     Serial.print(FAN_CURVE_EXPONENT);
-    Serial.println(") for more aggressive cooling at high temps");
+    Serial.println(F(") for more aggressive cooling at high temps"));
 }
 
 void loop() {
@@ -0,0 +1,155 @@
+#include "protocol_negotiator.h"
+#include <Arduino.h>
+
+ProtocolNegotiator::ProtocolNegotiator()
+    : channel(nullptr),
+      deviceId(0),
+      binary(false),
+      extended(false),
+      missedPolls(0),
+      waitStart(0),
+      waitDuration(0),
+      pushing(false),
+      heartbeat(0),
+      lastPush(0),
+      pushWaitStart(0),
+      pushWaitDuration(0) {
+}
+
+void ProtocolNegotiator::begin(SerialChannel* serialChannel, int device) {
+    channel = serialChannel;
+    deviceId = device;
+    binary = false;
+    extended = false;
+    pushing = false;
+}
+
+bool ProtocolNegotiator::shouldNegotiate() const {
+    return channel != nullptr && !binary && !extended &&
+           millis() - waitStart >= waitDuration;
+}
+
+bool ProtocolNegotiator::negotiate() {
+    char line[MAX_NEGOTIATION_LENGTH + 1];
+    
+    if (BINARY_PROTOCOL) {
+        channel->writeLine("PROTO:BIN");
+        
+        if (!channel->awaitLine("PROTO:", line, sizeof(line), RESPONSE_TIMEOUT)) {
+            // Daemon without format negotiation, or not running
+            postpone(BINARY_RETRY_INTERVAL);
+            return false;
+        }
+        
+        if (strcmp(line, "PROTO:OK:BIN") == 0) {
+            binary = true;
+            missedPolls = 0;
+            Serial.print(F("Device "));
+            Serial.print(deviceId + 1);
+            Serial.println(F(" switched to binary responses"));
+            return true;
+        }
+    }
+    
+    // Text responses carry the trend and load fields only when asked for
+    channel->writeLine("PROTO:EXT");
+    
+    if (!channel->awaitLine("PROTO:", line, sizeof(line), RESPONSE_TIMEOUT) ||
+        strcmp(line, "PROTO:OK:EXT") != 0) {
+        postpone(BINARY_RETRY_INTERVAL);
+        return false;
+    }
+    
+    extended = true;
+    missedPolls = 0;
+    Serial.print(F("Device "));
+    Serial.print(deviceId + 1);
+    Serial.println(F(" switched to extended text responses"));
+    return true;
+}
+
+void ProtocolNegotiator::recordPoll(bool answered) {
+    if (answered) {
+        missedPolls = 0;
+        return;
+    }
+    
+    // A daemon replaced by an older one ignores POLL:BIN and POLL:EXT
+    if ((binary || extended) && ++missedPolls >= BINARY_FALLBACK_MISSES) {
+        Serial.print(F("Device "));
+        Serial.print(deviceId + 1);
+        Serial.println(binary ? F(" silent in binary format, returning to text responses")
+                              : F(" silent in extended format, returning to plain text responses"));
+        
+        binary = false;
+        extended = false;
+        postpone(BINARY_RENEGOTIATE_DELAY);
+    }
+}
+
+bool ProtocolNegotiator::isBinary() const {
+    return binary;
+}
+
+bool ProtocolNegotiator::isExtended() const {
+    return extended;
+}
+
+bool ProtocolNegotiator::shouldRequestPush() const {
+    return PUSH_MODE && channel != nullptr && !pushing &&
+           millis() - pushWaitStart >= pushWaitDuration;
+}
+
+bool ProtocolNegotiator::requestPush() {
+    char line[MAX_NEGOTIATION_LENGTH + 1];
+    
+    channel->writeLine(binary ? "PUSH:BIN" : "PUSH:ON");
+    
+    if (!channel->awaitLine("PUSH:", line, sizeof(line), RESPONSE_TIMEOUT) ||
+        strncmp(line, "PUSH:OK:", 8) != 0 || atol(line + 8) <= 0) {
+        // Daemon without push support, push disabled, or not running
+        postponePush(PUSH_RETRY_INTERVAL);
+        return false;
+    }
+    
+    pushing = true;
+    heartbeat = atol(line + 8);
+    lastPush = millis();
+    Serial.print(F("Device "));
+    Serial.print(deviceId + 1);
+    Serial.print(F(" switched to push updates (heartbeat "));
+    Serial.print(heartbeat);
+    Serial.println(F("ms)"));
+    return true;
+}
+
+void ProtocolNegotiator::recordPush() {
+    lastPush = millis();
+}
+
+bool ProtocolNegotiator::isPushing() const {
+    return pushing;
+}
+
+bool ProtocolNegotiator::isStale() const {
+    return pushing && millis() - lastPush >= 2 * heartbeat + PUSH_STALE_MARGIN;
+}
+
+void ProtocolNegotiator::pushLost() {
+    Serial.print(F("Device "));
+    Serial.print(deviceId + 1);
+    Serial.println(F(" stopped pushing updates, polling it again"));
+    
+    pushing = false;
+    postponePush(PUSH_RENEGOTIATE_DELAY);
+}
+
+void ProtocolNegotiator::postpone(unsigned long duration) {
+    waitStart = millis();
+    waitDuration = duration;
+}
+
+void ProtocolNegotiator::postponePush(unsigned long duration) {
+    pushWaitStart = millis();
+    pushWaitDuration = duration;
+}
@@ -0,0 +1,44 @@
+#include "serial_channel.h"
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+
+SoftwareSerialChannel::SoftwareSerialChannel(SoftwareSerial* serialPort) : port(serialPort) {
+}
+
+void SoftwareSerialChannel::begin(long baudRate) {
+    // SoftwareSerial::begin() also makes this port the listening one
+    port->begin(baudRate);
+}
+
+void SoftwareSerialChannel::writeLine(const char* line) {
+    port->println(line);
+    port->flush();
+}
+
+int SoftwareSerialChannel::read() {
+    return port->available() ? port->read() : -1;
+}
+
+bool SoftwareSerialChannel::awaitLine(const char* prefix, char* line, size_t size, unsigned long timeout) {
+    unsigned long start = millis();
+    size_t length = 0;
+    
+    while (millis() - start < timeout) {
+        int c = read();
+        if (c < 0) {
+            continue;
+        }
+        
+        if (c == '\n') {
+            line[length] = '\0';
+            // Skip empty lines and stray responses, such as a late temperature reply
+            if (strncmp(line, prefix, strlen(prefix)) == 0) {
+                return true;
+            }
+            length = 0;
+        } else if (c != '\r' && length < size - 1) {
+            line[length++] = (char)c;
+        }
+    }
+    return false;
+}
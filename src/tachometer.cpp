@@ -10,7 +10,7 @@ Tachometer::Tachometer() : lastRpmCalcTime(0) {
 void Tachometer::begin() {
     pinMode(TACH_PIN, INPUT_PULLUP);
     attachInterrupt(digitalPinToInterrupt(TACH_PIN), tachISR, FALLING);
-    Serial.println("Tachometer initialized");
+    Serial.println(F("Tachometer initialized"));
 }
 
 void Tachometer::calculateRPM() {
@@ -23,9 +23,9 @@ void Tachometer::calculateRPM() {
     rpm = count * 30;
     
     // Log RPM via Serial
-    Serial.print("RPM: ");
+    Serial.print(F("RPM: "));
     Serial.print(rpm);
-    Serial.print(" | count: ");
+    Serial.print(F(" | count: "));
     Serial.println(count);
     
     lastRpmCalcTime = millis();
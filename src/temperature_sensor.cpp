@@ -3,14 +3,14 @@
 
 TemperatureSensor::TemperatureSensor() : fanController(nullptr) {
     for (int i = 0; i < NUM_DEVICES; i++) {
-        deviceTemps[i] = {0.0, 0.0, false, 0};
+        deviceTemps[i] = {0.0, 0.0, false, 0, 0, 0.0, 0.0, -1};
         deviceConnected[i] = false;
         missedPolls[i] = 0;
     }
 }
 
 void TemperatureSensor::begin() {
-    Serial.println("Temperature sensor initialized");
+    Serial.println(F("Temperature sensor initialized"));
 }
 
 void TemperatureSensor::setFanController(FanController* fc) {
@@ -22,9 +22,13 @@ bool TemperatureSensor::parseTemperatureData(int deviceId, const String& data) {
         return false;
     }
     
-    // Expected format: CPU:xx.x|NVME:xx.x
+    // Expected format: CPU:xx.x|NVME:xx.x[|AGE:ms][|DCPU:x.xx|DNVME:x.xx][|LOAD:pct]
     int cpuPos = data.indexOf("CPU:");
     int nvmePos = data.indexOf("|NVME:");
+    int agePos = data.indexOf("|AGE:");
+    int cpuSlopePos = data.indexOf("|DCPU:");
+    int nvmeSlopePos = data.indexOf("|DNVME:");
+    int loadPos = data.indexOf("|LOAD:");
     
     if (cpuPos != -1 && nvmePos != -1) {
         // Extract CPU temperature
@@ -32,43 +36,56 @@ bool TemperatureSensor::parseTemperatureData(int deviceId, const String& data) {
         float cpuTemp = cpuTempStr.toFloat();
         
         // Extract NVME temperature
-        String nvmeTempStr = data.substring(nvmePos + 6);
+        String nvmeTempStr = (agePos != -1) ? data.substring(nvmePos + 6, agePos) : data.substring(nvmePos + 6);
         float nvmeTemp = nvmeTempStr.toFloat();
         
-        // Update device data
-        deviceTemps[deviceId].cpuTemp = cpuTemp;
-        deviceTemps[deviceId].nvmeTemp = nvmeTemp;
-        deviceTemps[deviceId].isValid = true;
-        deviceTemps[deviceId].lastUpdateTime = millis();
+        // Extract sample age (optional, older daemons do not send it)
+        unsigned long sampleAge = (agePos != -1) ? data.substring(agePos + 5).toInt() : 0;
         
-        deviceConnected[deviceId] = true;
-        missedPolls[deviceId] = 0;
-        
-        // Log the parsed temperatures
-        Serial.print("Device ");
-        Serial.print(deviceId + 1);
-        Serial.print(" temperatures - CPU: ");
-        Serial.print(cpuTemp);
-        Serial.print("°C, NVME: ");
-        Serial.print(nvmeTemp);
-        Serial.println("°C");
+        // Extract temperature trends (optional, toFloat() stops at the next separator)
+        float cpuSlope = (cpuSlopePos != -1) ? data.substring(cpuSlopePos + 6).toFloat() : 0.0;
+        float nvmeSlope = (nvmeSlopePos != -1) ? data.substring(nvmeSlopePos + 7).toFloat() : 0.0;
         
-        // IMPORTANT: Update fan speed immediately based on new temperature data
-        if (fanController) {
-            fanController->updateFanSpeed(*this);
-        }
+        // Extract CPU load (optional)
+        int cpuLoad = (loadPos != -1) ? constrain(data.substring(loadPos + 6).toInt(), 0, 100) : -1;
         
+        updateTemperatureData(deviceId, cpuTemp, nvmeTemp, sampleAge, cpuSlope, nvmeSlope, cpuLoad);
         return true;
     }
     
     return false;
 }
 
+void TemperatureSensor::updateTemperatureData(int deviceId, float cpuTemp, float nvmeTemp, unsigned long sampleAge,
+                                              float cpuSlope, float nvmeSlope, int cpuLoad) {
+    if (deviceId < 0 || deviceId >= NUM_DEVICES) {
+        return;
+    }
+    
+    // Update device data
+    deviceTemps[deviceId].cpuTemp = cpuTemp;
+    deviceTemps[deviceId].nvmeTemp = nvmeTemp;
+    deviceTemps[deviceId].isValid = true;
+    deviceTemps[deviceId].lastUpdateTime = millis();
+    deviceTemps[deviceId].sampleAgeMs = sampleAge;
+    deviceTemps[deviceId].cpuSlope = cpuSlope;
+    deviceTemps[deviceId].nvmeSlope = nvmeSlope;
+    deviceTemps[deviceId].cpuLoad = cpuLoad;
+    
+    deviceConnected[deviceId] = true;
+    missedPolls[deviceId] = 0;
+    
+    // IMPORTANT: Update fan speed immediately based on new temperature data
+    if (fanController) {
+        fanController->updateFanSpeed(*this);
+    }
+}
+
 TemperatureData TemperatureSensor::getDeviceTemperature(int deviceId) const {
     if (deviceId >= 0 && deviceId < NUM_DEVICES) {
         return deviceTemps[deviceId];
     }
-    return {0.0, 0.0, false, 0};
+    return {0.0, 0.0, false, 0, 0, 0.0, 0.0, -1};
 }
 
 void TemperatureSensor::getHighestTemperatures(float& highestCpu, float& highestNvme) const {
@@ -87,6 +104,34 @@ void TemperatureSensor::getHighestTemperatures(float& highestCpu, float& highest
     }
 }
 
+void TemperatureSensor::getHighestSlopes(float& highestCpuSlope, float& highestNvmeSlope) const {
+    highestCpuSlope = 0.0;
+    highestNvmeSlope = 0.0;
+    
+    // Only connected devices: a saved reading from a lost device has no current trend
+    for (int i = 0; i < NUM_DEVICES; i++) {
+        if (deviceTemps[i].isValid && deviceConnected[i]) {
+            if (deviceTemps[i].cpuSlope > highestCpuSlope) {
+                highestCpuSlope = deviceTemps[i].cpuSlope;
+            }
+            if (deviceTemps[i].nvmeSlope > highestNvmeSlope) {
+                highestNvmeSlope = deviceTemps[i].nvmeSlope;
+            }
+        }
+    }
+}
+
+int TemperatureSensor::getHighestLoad() const {
+    int highestLoad = -1;
+    
+    for (int i = 0; i < NUM_DEVICES; i++) {
+        if (deviceTemps[i].isValid && deviceConnected[i] && deviceTemps[i].cpuLoad > highestLoad) {
+            highestLoad = deviceTemps[i].cpuLoad;
+        }
+    }
+    return highestLoad;
+}
+
 bool TemperatureSensor::hasTemperatureData() const {
     for (int i = 0; i < NUM_DEVICES; i++) {
         if (deviceTemps[i].isValid && (deviceTemps[i].cpuTemp > 0.0 || deviceTemps[i].nvmeTemp > 0.0)) {
@@ -100,16 +145,16 @@ void TemperatureSensor::handleMissedPoll(int deviceId) {
     if (deviceId >= 0 && deviceId < NUM_DEVICES) {
         missedPolls[deviceId]++;
         
-        Serial.print("Device ");
+        Serial.print(F("Device "));
         Serial.print(deviceId + 1);
-        Serial.print(" missed polls: ");
+        Serial.print(F(" missed polls: "));
         Serial.println(missedPolls[deviceId]);
         
         if (missedPolls[deviceId] >= MAX_MISSED_POLLS && deviceConnected[deviceId]) {
             deviceConnected[deviceId] = false;
-            Serial.print("Device ");
+            Serial.print(F("Device "));
             Serial.print(deviceId + 1);
-            Serial.println(" disconnected (too many missed polls)");
+            Serial.println(F(" disconnected (too many missed polls)"));
             
             // IMPORTANT: Update fan speed when a device disconnects
             if (fanController) {
@@ -127,27 +172,29 @@ bool TemperatureSensor::isDeviceConnected(int deviceId) const {
 }
 
 void TemperatureSensor::printTemperatureSummary() const {
-    Serial.println("=== Temperature Summary ===");
+    Serial.println(F("=== Temperature Summary ==="));
     for (int i = 0; i < NUM_DEVICES; i++) {
         if (deviceConnected[i]) {
-            Serial.print("Device ");
+            Serial.print(F("Device "));
             Serial.print(i + 1);
-            Serial.print(": CPU=");
+            Serial.print(F(": CPU="));
             Serial.print(deviceTemps[i].cpuTemp);
-            Serial.print("°C, NVME=");
+            Serial.print(F("°C, NVME="));
             Serial.print(deviceTemps[i].nvmeTemp);
-            Serial.print("°C, missed=");
+            Serial.print(F("°C, age="));
+            Serial.print(deviceTemps[i].sampleAgeMs);
+            Serial.print(F("ms, missed="));
             Serial.println(missedPolls[i]);
         } else {
-            Serial.print("Device ");
+            Serial.print(F("Device "));
             Serial.print(i + 1);
-            Serial.print(": Not connected (missed=");
+            Serial.print(F(": Not connected (missed="));
             Serial.print(missedPolls[i]);
-            Serial.print(", last CPU=");
+            Serial.print(F(", last CPU="));
             Serial.print(deviceTemps[i].cpuTemp);
-            Serial.print("°C, last NVME=");
+            Serial.print(F("°C, last NVME="));
             Serial.print(deviceTemps[i].nvmeTemp);
-            Serial.println("°C)");
+            Serial.println(F("°C)"));
         }
     }
 }
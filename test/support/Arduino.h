@@ -0,0 +1,36 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// The part of the Arduino core used by the protocol code, for host tests.
+// Time only passes when a test or the fake channel advances it.
+
+#include <stdio.h>
+#include <string.h>
+
+inline unsigned long& hostMillis() {
+    static unsigned long now = 0;
+    return now;
+}
+
+inline unsigned long millis() {
+    return hostMillis();
+}
+
+inline void delay(unsigned long ms) {
+    hostMillis() += ms;
+}
+
+// Strings stay in RAM on a host
+#define F(string) (string)
+
+// Console output is discarded
+class HostSerial {
+public:
+    template <typename T> size_t print(T) { return 0; }
+    template <typename T> size_t println(T) { return 0; }
+    size_t println() { return 0; }
+};
+
+static HostSerial Serial __attribute__((unused));
+
+#endif // HOST_ARDUINO_H
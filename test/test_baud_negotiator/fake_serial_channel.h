@@ -0,0 +1,110 @@
+#ifndef FAKE_SERIAL_CHANNEL_H
+#define FAKE_SERIAL_CHANNEL_H
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <deque>
+#include <string>
+#include "config.h"
+#include "serial_channel.h"
+
+// Simulated link to a daemon that implements the BAUD/ECHO/COMMIT exchange.
+// Lines only arrive while both ends run at the same rate, and waiting for a
+// line that never comes advances the host clock by the full timeout.
+class FakeSerialChannel : public SerialChannel {
+private:
+    std::deque<std::string> replies;    // Lines sent by the daemon, not read yet
+    long daemonSide;                    // Rate of the daemon end of the link
+    long uncommittedRate;               // Rate to return to without BAUD:COMMIT, 0 if none
+    unsigned long switchedAt;
+    
+    void reply(const std::string& line) {
+        replies.push_back(line);
+    }
+    
+    // The daemon returns to the previous rate 2 seconds after a switch without commit
+    void expireSwitch() {
+        if (uncommittedRate != 0 && millis() - switchedAt >= 2000) {
+            daemonSide = uncommittedRate;
+            uncommittedRate = 0;
+        }
+    }
+
+public:
+    long rate;              // Rate of the controller end of the link
+    long maxRate;           // Highest rate the daemon accepts
+    bool connected;         // false: nothing answers, as with an older daemon or none
+    long corruptAbove;      // Echoes at higher rates come back damaged, 0 for never
+    bool dropCommit;        // The daemon never answers BAUD:COMMIT
+    
+    FakeSerialChannel()
+        : daemonSide(BAUD_RATE),
+          uncommittedRate(0),
+          switchedAt(0),
+          rate(BAUD_RATE),
+          maxRate(BAUD_RATES[NUM_BAUD_RATES - 1]),
+          connected(true),
+          corruptAbove(0),
+          dropCommit(false) {
+    }
+    
+    long daemonRate() {
+        expireSwitch();
+        return daemonSide;
+    }
+    
+    void begin(long baudRate) override {
+        rate = baudRate;
+    }
+    
+    void writeLine(const char* line) override {
+        expireSwitch();
+        if (!connected || rate != daemonSide) {
+            return;
+        }
+        
+        std::string command(line);
+        if (command == "BAUD:COMMIT") {
+            if (!dropCommit) {
+                uncommittedRate = 0;
+                reply("BAUD:OK");
+            }
+        } else if (command.compare(0, 5, "BAUD:") == 0) {
+            long requested = atol(line + 5);
+            if (requested > maxRate) {
+                reply("BAUD:NO:" + std::to_string(maxRate));
+                return;
+            }
+            // Answered at the current rate, then the daemon switches
+            reply(command.replace(0, 5, "BAUD:OK:"));
+            uncommittedRate = daemonSide;
+            daemonSide = requested;
+            switchedAt = millis();
+        } else if (command.compare(0, 5, "ECHO:") == 0) {
+            if (corruptAbove != 0 && daemonSide > corruptAbove) {
+                command[command.size() - 1] ^= 0x20;
+            }
+            reply(command);
+        }
+    }
+    
+    // Lines are only consumed whole, through awaitLine()
+    int read() override {
+        return -1;
+    }
+    
+    bool awaitLine(const char* prefix, char* line, size_t size, unsigned long timeout) override {
+        while (!replies.empty()) {
+            std::string next = replies.front();
+            replies.pop_front();
+            if (next.compare(0, strlen(prefix), prefix) == 0) {
+                snprintf(line, size, "%s", next.c_str());
+                return true;
+            }
+        }
+        delay(timeout);
+        return false;
+    }
+};
+
+#endif // FAKE_SERIAL_CHANNEL_H
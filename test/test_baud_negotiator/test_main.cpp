@@ -0,0 +1,111 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "baud_negotiator.h"
+#include "fake_serial_channel.h"
+
+static FakeSerialChannel channel;
+static BaudNegotiator negotiator;
+
+void setUp() {
+    channel = FakeSerialChannel();
+    negotiator = BaudNegotiator();
+    negotiator.begin(&channel, 0);
+}
+
+void tearDown() {
+}
+
+static void test_steps_up_through_every_rate() {
+    TEST_ASSERT_TRUE(negotiator.shouldNegotiate());
+    TEST_ASSERT_TRUE(negotiator.negotiate());
+    TEST_ASSERT_EQUAL(57600, negotiator.getBaudRate());
+    TEST_ASSERT_EQUAL(57600, channel.rate);
+    
+    TEST_ASSERT_TRUE(negotiator.negotiate());
+    TEST_ASSERT_EQUAL(115200, negotiator.getBaudRate());
+    TEST_ASSERT_EQUAL(115200, channel.rate);
+    
+    // Committed: the daemon stays at the new rate
+    delay(5000);
+    TEST_ASSERT_EQUAL(115200, channel.daemonRate());
+    TEST_ASSERT_FALSE(negotiator.shouldNegotiate());
+}
+
+static void test_timeout_keeps_rate_and_postpones() {
+    channel.connected = false;
+    
+    TEST_ASSERT_FALSE(negotiator.negotiate());
+    TEST_ASSERT_EQUAL(BAUD_RATE, negotiator.getBaudRate());
+    TEST_ASSERT_EQUAL(BAUD_RATE, channel.rate);
+    
+    TEST_ASSERT_FALSE(negotiator.shouldNegotiate());
+    delay(BAUD_RETRY_INTERVAL);
+    TEST_ASSERT_TRUE(negotiator.shouldNegotiate());
+}
+
+static void test_refused_rate_becomes_ceiling() {
+    channel.maxRate = 57600;
+    
+    TEST_ASSERT_TRUE(negotiator.negotiate());
+    TEST_ASSERT_FALSE(negotiator.negotiate());
+    TEST_ASSERT_EQUAL(57600, negotiator.getBaudRate());
+    
+    delay(BAUD_RETRY_INTERVAL);
+    TEST_ASSERT_FALSE(negotiator.shouldNegotiate());
+}
+
+static void test_failed_echo_returns_to_previous_rate() {
+    channel.corruptAbove = 57600;
+    
+    TEST_ASSERT_TRUE(negotiator.negotiate());
+    TEST_ASSERT_FALSE(negotiator.negotiate());
+    TEST_ASSERT_EQUAL(57600, negotiator.getBaudRate());
+    TEST_ASSERT_EQUAL(57600, channel.rate);
+    
+    // Without the commit the daemon comes back to the same rate
+    delay(2000);
+    TEST_ASSERT_EQUAL(57600, channel.daemonRate());
+    TEST_ASSERT_FALSE(negotiator.shouldNegotiate());
+}
+
+static void test_missing_commit_returns_to_previous_rate() {
+    channel.dropCommit = true;
+    
+    TEST_ASSERT_FALSE(negotiator.negotiate());
+    TEST_ASSERT_EQUAL(BAUD_RATE, negotiator.getBaudRate());
+    TEST_ASSERT_EQUAL(BAUD_RATE, channel.rate);
+    
+    delay(2000);
+    TEST_ASSERT_EQUAL(BAUD_RATE, channel.daemonRate());
+}
+
+static void test_missed_polls_fall_back_to_base_rate() {
+    TEST_ASSERT_TRUE(negotiator.negotiate());
+    
+    for (int i = 0; i < BAUD_FALLBACK_MISSES - 1; i++) {
+        negotiator.recordPoll(false);
+    }
+    negotiator.recordPoll(true);
+    TEST_ASSERT_EQUAL(57600, negotiator.getBaudRate());
+    
+    for (int i = 0; i < BAUD_FALLBACK_MISSES; i++) {
+        negotiator.recordPoll(false);
+    }
+    TEST_ASSERT_EQUAL(BAUD_RATE, negotiator.getBaudRate());
+    TEST_ASSERT_EQUAL(BAUD_RATE, channel.rate);
+    
+    TEST_ASSERT_FALSE(negotiator.shouldNegotiate());
+    delay(BAUD_RENEGOTIATE_DELAY);
+    TEST_ASSERT_TRUE(negotiator.shouldNegotiate());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_steps_up_through_every_rate);
+    RUN_TEST(test_timeout_keeps_rate_and_postpones);
+    RUN_TEST(test_refused_rate_becomes_ceiling);
+    RUN_TEST(test_failed_echo_returns_to_previous_rate);
+    RUN_TEST(test_missing_commit_returns_to_previous_rate);
+    RUN_TEST(test_missed_polls_fall_back_to_base_rate);
+    return UNITY_END();
+}